@@ -9,9 +9,26 @@
 #include <array>
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <sstream>
+#include <iostream>
+#include <cstddef>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <type_traits>
 #include "point.h"
 
+// vectorization hints for the batch functions, emitted only if OpenMP is enabled
+// (-fopenmp, or -fopenmp-simd together with -DSIMD), otherwise the compiler decides on its own
+#if defined(_OPENMP) || defined(SIMD)
+#define ALGORITHMS_PRAGMA(x) _Pragma(#x)
+#else
+#define ALGORITHMS_PRAGMA(x)
+#endif
+
 class algorithms {
 public:
     // Implementation of the TSP problem
@@ -86,6 +103,64 @@ public:
         return delta;
     }
 
+    // Batch (structure of arrays) variants of the distance functions above. The coordinates are passed as
+    // contiguous x and y arrays so that the loops are vectorized by the compiler (compile with -O3 or
+    // -fopenmp-simd to enable the simd pragmas). For int, the coordinates should stay below 2^15 in magnitude
+    // to avoid an overflow of the squared distances.
+    static constexpr size_t batchBlockSize = 256;
+
+    // squared distances of the point (px, py) to the n points (xs[i], ys[i]): out[i] = (px - xs[i])^2 + (py - ys[i])^2
+    template<typename T>
+    static void distanceSquare(T px, T py, const T* xs, const T* ys, size_t n, T* out) {
+        ALGORITHMS_PRAGMA(omp simd)
+        for (size_t i = 0; i < n; ++i) {
+            const T dx = px - xs[i];
+            const T dy = py - ys[i];
+            out[i] = dx * dx + dy * dy;
+        }
+    }
+
+    // index of the point (xs[i], ys[i]) closest to (px, py) and its squared distance.
+    // Returns the first index on ties and (n, max) for n = 0.
+    template<typename T>
+    static std::pair<size_t, T> argminDistanceSquare(T px, T py, const T* xs, const T* ys, size_t n) {
+        T buffer[batchBlockSize];
+        std::pair<size_t, T> best = {n, std::numeric_limits<T>::max()};
+        for (size_t start = 0; start < n; start += batchBlockSize) {
+            const size_t count = std::min(batchBlockSize, n - start);
+            distanceSquare(px, py, xs + start, ys + start, count, buffer);
+            const T blockMin = minimum(buffer, count);
+            if (blockMin < best.second)
+                best = {start + firstIndexOf(buffer, count, blockMin), blockMin};
+        }
+        return best;
+    }
+
+    // for n lines with the endpoints (x0[i], y0[i]) and (x1[i], y1[i]): the line with the endpoint closest to
+    // (px, py), whether the closest endpoint is the second one (x1, y1) and the squared distance.
+    // This is the batch version of minimalPLineDistance() / minimalPLinePoint().
+    template<typename T>
+    static std::tuple<size_t, bool, T> minimalPLineDistance(T px, T py, const T* x0, const T* y0, const T* x1, const T* y1, size_t n) {
+        T buffer0[batchBlockSize];
+        T buffer1[batchBlockSize];
+        T buffer[batchBlockSize];
+        std::tuple<size_t, bool, T> best = {n, false, std::numeric_limits<T>::max()};
+        for (size_t start = 0; start < n; start += batchBlockSize) {
+            const size_t count = std::min(batchBlockSize, n - start);
+            distanceSquare(px, py, x0 + start, y0 + start, count, buffer0);
+            distanceSquare(px, py, x1 + start, y1 + start, count, buffer1);
+            ALGORITHMS_PRAGMA(omp simd)
+            for (size_t i = 0; i < count; ++i)
+                buffer[i] = std::min(buffer0[i], buffer1[i]);
+            const T blockMin = minimum(buffer, count);
+            if (blockMin < std::get<2>(best)) {
+                const size_t i = firstIndexOf(buffer, count, blockMin);
+                best = {start + i, buffer1[i] < buffer0[i], blockMin};
+            }
+        }
+        return best;
+    }
+
     // constrain a number between two boundaries
     template<typename T> 
     inline static T constrain(T value, T min, T max) {
@@ -93,28 +168,180 @@ public:
     }
 
     // convert string to arbitrary data type and constrain if needed between lower and upper
+    // (numbers are parsed with std::from_chars, other types and characters with a std::istringstream)
     template<typename T>
     static inline T strTo(const std::string& str, T lower = 0, T upper = 0) {
         T tmp = 0;
-        try {
+        if constexpr (isNumber<T>) {
+            parseNumber(str.data(), str.data() + str.size(), tmp);
+        } else {
             std::istringstream(str) >> tmp;
-            if (lower != 0 || upper != 0) {
-                if (tmp < lower || tmp > upper) {
-                    std::cout << "Warning: Number not in range: " << tmp << ", (" << lower << ", " << upper << ")" << std::endl;
-                    return constrain<T>(tmp, lower, upper);
-                }
+        }
+        if (lower != 0 || upper != 0) {
+            if (tmp < lower || tmp > upper) {
+                std::cout << "Warning: Number not in range: " << tmp << ", (" << lower << ", " << upper << ")" << std::endl;
+                return constrain<T>(tmp, lower, upper);
             }
-        } catch (const std::exception& e) {
-            std::cout << "Warning: " << e.what() << ": No valid input: " << tmp << std::endl;
         }
         return tmp;
     }
 
+    // parse all numbers of the buffer [first, last) into out (at most capacity values), the numbers are separated by
+    // the delimiter and/or whitespace (e.g. a whole level file). Values outside of [lower, upper] are constrained
+    // silently (if lower != 0 or upper != 0), their number is stored in clamped (if not nullptr).
+    // Returns the number of values written to out.
+    template<typename T>
+    static size_t strToArray(const char* first, const char* last, char delimiter, T* out, size_t capacity, T lower = 0, T upper = 0, size_t* clamped = nullptr) {
+        static_assert(isNumber<T>, "strToArray parses numbers");
+        const bool constrained = lower != 0 || upper != 0;
+        size_t n = 0;
+        size_t nclamped = 0;
+        while (n < capacity) {
+            // skip separators
+            while (first != last && (*first == delimiter || isSpace(*first)))
+                ++first;
+            if (first == last)
+                break;
+            T value = 0;
+            const char* end = parseNumber(first, last, value);
+            // skip the rest of an invalid token (its value is 0, like for strTo)
+            while (end != last && *end != delimiter && !isSpace(*end))
+                ++end;
+            if (constrained && (value < lower || value > upper)) {
+                value = constrain<T>(value, lower, upper);
+                nclamped++;
+            }
+            out[n++] = value;
+            first = end;
+        }
+        if (clamped)
+            *clamped = nclamped;
+        return n;
+    }
+
+    // the same for a whole string, the values are appended to out
+    template<typename T>
+    static size_t strToVector(const std::string& buffer, char delimiter, std::vector<T>& out, T lower = 0, T upper = 0, size_t* clamped = nullptr) {
+        // every value needs at least one character and one separator
+        const size_t offset = out.size();
+        out.resize(offset + buffer.size() / 2 + 1);
+        const size_t n = strToArray(buffer.data(), buffer.data() + buffer.size(), delimiter, out.data() + offset, out.size() - offset, lower, upper, clamped);
+        out.resize(offset + n);
+        return n;
+    }
+
     // Convert arbitrary type to string
+    // (numbers are formatted with std::to_chars like by a std::stringstream, other types and characters with a std::stringstream)
     template<typename T>
     static inline std::string typeToStr(T a) {
-        std::stringstream ss;
-        ss << a;
-        return ss.str();
+        if constexpr (isNumber<T>) {
+            char buffer[64];
+            return std::string(buffer, toChars(buffer, buffer + sizeof(buffer), a));
+        } else {
+            std::stringstream ss;
+            ss << a;
+            return ss.str();
+        }
+    }
+
+    // write a number to [first, last) like typeToStr, without allocation. Returns the end of the written characters.
+    template<typename T>
+    static char* toChars(char* first, char* last, T value) {
+        static_assert(isNumber<T>, "toChars formats numbers");
+        if constexpr (std::is_integral_v<T>) {
+            return std::to_chars(first, last, value).ptr;
+        } else {
+#if defined(__cpp_lib_to_chars)
+            // the default format of a stream: %g with precision 6
+            return std::to_chars(first, last, value, std::chars_format::general, 6).ptr;
+#else
+            const int n = std::snprintf(first, last - first, "%g", static_cast<double>(value));
+            return n < 0 ? first : first + std::min<std::ptrdiff_t>(n, last - first - 1);
+#endif
+        }
+    }
+
+private:
+    // types that are parsed and formatted as numbers (streams treat bool and the character types differently)
+    template<typename T>
+    static constexpr bool isNumber = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char> &&
+                                     !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char>;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+    }
+
+    // parse a number from [first, last) like a std::istream: leading whitespace and a '+' are skipped, the value
+    // is 0 if there is no number (also for inf and nan), numbers that are out of range saturate and negative numbers
+    // wrap around for unsigned types. Returns the end of the number.
+    template<typename T>
+    static const char* parseNumber(const char* first, const char* last, T& value) {
+        while (first != last && isSpace(*first))
+            ++first;
+        if (first != last && *first == '+' && last - first > 1 && *(first + 1) != '-')
+            ++first;
+        if constexpr (std::is_integral_v<T>) {
+            if constexpr (std::is_unsigned_v<T>) {
+                if (first != last && *first == '-') {
+                    const std::from_chars_result result = std::from_chars(first + 1, last, value);
+                    if (result.ec == std::errc::result_out_of_range)
+                        value = std::numeric_limits<T>::max();
+                    else if (result.ec != std::errc())
+                        value = 0;
+                    else
+                        value = static_cast<T>(0 - value);
+                    return result.ptr;
+                }
+            }
+            const std::from_chars_result result = std::from_chars(first, last, value);
+            if (result.ec == std::errc::result_out_of_range)
+                value = *first == '-' ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+            else if (result.ec != std::errc())
+                value = 0;
+            return result.ptr;
+        } else {
+            const char* digits = first != last && *first == '-' ? first + 1 : first;
+            if (digits != last && ((*digits >= 'a' && *digits <= 'z') || (*digits >= 'A' && *digits <= 'Z'))) {
+                value = 0;
+                return first;
+            }
+#if defined(__cpp_lib_to_chars)
+            const std::from_chars_result result = std::from_chars(first, last, value);
+            if (result.ec == std::errc())
+                return result.ptr;
+            if (result.ec != std::errc::result_out_of_range) {
+                value = 0;
+                return result.ptr;
+            }
+#endif
+            // strtod needs a terminated string, numbers are short
+            char buffer[128];
+            const size_t n = std::min<size_t>(last - first, sizeof(buffer) - 1);
+            std::copy(first, first + n, buffer);
+            buffer[n] = 0;
+            char* end = buffer;
+            const long double parsed = std::strtold(buffer, &end);
+            value = static_cast<T>(constrain<long double>(parsed, std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max()));
+            return first + (end - buffer);
+        }
+    }
+
+    // minimum of n values (vectorized reduction)
+    template<typename T>
+    static T minimum(const T* values, size_t n) {
+        T m = std::numeric_limits<T>::max();
+        ALGORITHMS_PRAGMA(omp simd reduction(min:m))
+        for (size_t i = 0; i < n; ++i)
+            m = values[i] < m ? values[i] : m;
+        return m;
+    }
+
+    // index of the first occurrence of value
+    template<typename T>
+    static size_t firstIndexOf(const T* values, size_t n, T value) {
+        for (size_t i = 0; i < n; ++i)
+            if (values[i] == value)
+                return i;
+        return n;
     }
 };
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "backend.h"
+#include <SDL2_gfxPrimitives.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "algorithms.h"
+
+void frameGeometry::clear() {
+    points.clear();
+    polylines.clear();
+    ellipses.clear();
+    particles.clear();
+}
+
+void frameGeometry::addObject(const object& o, int priority) {
+    if (o.npoints() == 0) {
+        const types::point<float> center = o.getCenter();
+        ellipses.push_back({o.x(), o.y(), o.hsize() / 2, o.vsize() / 2, center.r, center.g, center.b, center.a});
+        return;
+    }
+    const size_t first = points.size();
+    points.resize(first + o.npoints());
+    o.getPoints(points.data() + first);
+    const bool onScreen = o.xcenter() >= 0 && o.xcenter() <= renderer::screen_width &&
+                          o.ycenter() >= 0 && o.ycenter() <= renderer::screen_height;
+    polylines.push_back({first, points.size(), priority, onScreen});
+}
+
+sdlBackend::sdlBackend(SDL_Renderer* ren) : m_ren(ren) {
+}
+
+void sdlBackend::drawFrame(const frameGeometry& frame) {
+    for (const frameGeometry::ellipse& e : frame.ellipses)
+        filledEllipseRGBA(m_ren, (int)e.x, (int)e.y, (int)e.rx, (int)e.ry, e.r, e.g, e.b, e.a);
+    for (const frameGeometry::polylineRange& p : frame.polylines) {
+        for (size_t i = p.first + 1; i < p.last; ++i) {
+            const types::point<float>& a = frame.points[i - 1];
+            const types::point<float>& b = frame.points[i];
+            lineRGBA(m_ren, (int)b.x, (int)b.y, (int)a.x, (int)a.y, b.r, b.g, b.b, b.a);
+        }
+    }
+    if (frame.particles.empty())
+        return;
+    // all particles as squares in one call
+    thread_local std::vector<SDL_Vertex> vertices;
+    thread_local std::vector<int> indices;
+    vertices.resize(4 * frame.particles.size());
+    indices.resize(6 * frame.particles.size());
+    for (size_t i = 0; i < frame.particles.size(); ++i) {
+        const frameGeometry::particle& p = frame.particles[i];
+        const float s = std::max(p.size, 0.5f);
+        const SDL_Color c = {(Uint8)algorithms::constrain(p.r, 0, 255), (Uint8)algorithms::constrain(p.g, 0, 255),
+                             (Uint8)algorithms::constrain(p.b, 0, 255), (Uint8)algorithms::constrain(p.a, 0, 255)};
+        vertices[4 * i + 0] = {{p.x - s, p.y - s}, c, {0, 0}};
+        vertices[4 * i + 1] = {{p.x + s, p.y - s}, c, {0, 0}};
+        vertices[4 * i + 2] = {{p.x + s, p.y + s}, c, {0, 0}};
+        vertices[4 * i + 3] = {{p.x - s, p.y + s}, c, {0, 0}};
+        const int v = static_cast<int>(4 * i);
+        const int quad[6] = {v, v + 1, v + 2, v, v + 2, v + 3};
+        std::copy(quad, quad + 6, indices.begin() + 6 * i);
+    }
+    SDL_RenderGeometry(m_ren, nullptr, vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
+}
+
+void nullBackend::drawFrame(const frameGeometry& frame) {
+    frames++;
+    polylines += frame.polylines.size();
+    points += frame.points.size();
+    ellipses += frame.ellipses.size();
+    particles += frame.particles.size();
+}
+
+fanOutBackend::fanOutBackend(const std::vector<renderBackend*>& backends) : m_backends(backends) {
+}
+
+void fanOutBackend::add(renderBackend* backend) {
+    m_backends.push_back(backend);
+}
+
+void fanOutBackend::drawFrame(const frameGeometry& frame) {
+    for (renderBackend* backend : m_backends)
+        backend->drawFrame(frame);
+}
+
+#ifdef LUMAX_OUTPUT
+lumaxBackend::lumaxBackend(void* lumaxHandle, renderer::lumaxRenderer& ren, int scanSpeed)
+    : m_handle(lumaxHandle), m_ren(ren), m_scanSpeed(scanSpeed) {
+}
+
+void lumaxBackend::drawFrame(const frameGeometry& frame) {
+    // ellipses are traced as closed outlines (the resampling of the renderer fills the gaps between the vertices)
+    thread_local std::vector<types::point<float>> outline;
+    const int segments = 24;
+    outline.resize(segments + 1);
+    for (const frameGeometry::ellipse& e : frame.ellipses) {
+        if (e.x < 0 || e.x > renderer::screen_width || e.y < 0 || e.y > renderer::screen_height)
+            continue;
+        for (int i = 0; i <= segments; ++i) {
+            const float angle = 6.2831853f * i / segments;
+            outline[i] = {e.x + e.rx * std::cos(angle), e.y + e.ry * std::sin(angle), e.r, e.g, e.b, e.a, false};
+        }
+        renderer::drawPolyline(outline.data(), outline.size(), m_ren);
+    }
+    for (const frameGeometry::polylineRange& p : frame.polylines) {
+        if (p.onScreen)
+            renderer::drawPolyline(frame.points.data() + p.first, p.last - p.first, m_ren, p.priority);
+    }
+    // every particle is a dot of its own, so that the frame-rate governor can thin them out
+    for (const frameGeometry::particle& p : frame.particles) {
+        if (p.x < 0 || p.x > renderer::screen_width || p.y < 0 || p.y > renderer::screen_height)
+            continue;
+        // the laser has no alpha channel, fading particles become darker instead
+        const int a = algorithms::constrain(p.a, 0, 255);
+        const types::point<float> dot = {p.x, p.y, p.r * a / 255, p.g * a / 255, p.b * a / 255, 255, false};
+        if (dot.r == 0 && dot.g == 0 && dot.b == 0)
+            continue;
+        renderer::drawPolyline(&dot, 1, m_ren, std::numeric_limits<int>::min());
+    }
+    renderer::sendPointsToLumax(m_handle, m_ren, m_scanSpeed);
+}
+
+void lumaxBackend::setScanSpeed(int scanSpeed) {
+    m_scanSpeed = scanSpeed;
+}
+#endif
\ No newline at end of file
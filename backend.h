@@ -0,0 +1,112 @@
+/*
+ *  backend.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <SDL.h>
+#include "object.h"
+#include "point.h"
+#include "renderer.h"
+
+// The geometry of a whole frame, collected in one traversal of the scene and handed to the output backends in one call.
+// Objects with points become polylines, objects without points become filled ellipses (like in renderer::drawObject).
+struct frameGeometry {
+    // polyline i consists of the points [first, last)
+    struct polylineRange {
+        size_t first;
+        size_t last;
+        // objects with lower priority are dropped first by backends with a limited budget (see renderer::lumaxParameters)
+        int priority;
+        // the center of the object lies inside the screen (only those objects are drawn by the laser)
+        bool onScreen;
+    };
+
+    struct ellipse {
+        float x, y;
+        // radii
+        float rx, ry;
+        int r, g, b, a;
+    };
+
+    // a particle (see particleSystem), drawn as a filled square or circle or as a single laser dot
+    struct particle {
+        float x, y;
+        float size;
+        int r, g, b, a;
+    };
+
+    // vertices of all polylines in screen coordinates
+    std::vector<types::point<float>> points;
+    std::vector<polylineRange> polylines;
+    std::vector<ellipse> ellipses;
+    std::vector<particle> particles;
+
+    // remove all geometry, the memory is kept for the next frame
+    void clear();
+
+    // append the geometry of an object
+    void addObject(const object& o, int priority = 0);
+};
+
+// An output of the renderer
+class renderBackend {
+public:
+    virtual ~renderBackend() = default;
+
+    // draw the geometry of a frame
+    virtual void drawFrame(const frameGeometry& frame) = 0;
+};
+
+// draws to a SDL_Renderer (the caller clears and presents the renderer)
+class sdlBackend : public renderBackend {
+public:
+    sdlBackend(SDL_Renderer* ren);
+    void drawFrame(const frameGeometry& frame) override;
+
+private:
+    SDL_Renderer* m_ren;
+};
+
+// does not draw anything, but counts the geometry (e.g. to profile the scene without the cost of drawing)
+class nullBackend : public renderBackend {
+public:
+    void drawFrame(const frameGeometry& frame) override;
+
+    size_t frames = 0;
+    size_t polylines = 0;
+    size_t points = 0;
+    size_t ellipses = 0;
+    size_t particles = 0;
+};
+
+// forwards every frame to several backends
+class fanOutBackend : public renderBackend {
+public:
+    fanOutBackend(const std::vector<renderBackend*>& backends = {});
+    void add(renderBackend* backend);
+    void drawFrame(const frameGeometry& frame) override;
+
+private:
+    std::vector<renderBackend*> m_backends;
+};
+
+#ifdef LUMAX_OUTPUT
+// draws the polylines, the ellipses (as outlines) and the particles (as dots with the lowest priority) to the Lumax renderer
+// and sends the frame to the device
+// (the frame is only recorded if the handle is nullptr and ren.recorder is set)
+class lumaxBackend : public renderBackend {
+public:
+    lumaxBackend(void* lumaxHandle, renderer::lumaxRenderer& ren, int scanSpeed);
+    void drawFrame(const frameGeometry& frame) override;
+
+    void setScanSpeed(int scanSpeed);
+
+private:
+    void* m_handle;
+    renderer::lumaxRenderer& m_ren;
+    int m_scanSpeed;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "bvh.h"
+
+aabbTree::aabbTree(float margin, float displacementMultiplier) :
+    m_root(nullNode), m_freeList(nullNode), m_leafs(0), m_margin(margin), m_displacementMultiplier(displacementMultiplier) {}
+
+int aabbTree::allocateNode() {
+    if (m_freeList == nullNode) {
+        m_nodes.push_back(node());
+        m_freeList = static_cast<int>(m_nodes.size()) - 1;
+        m_nodes.back().parent = nullNode;
+    }
+    const int id = m_freeList;
+    node& n = m_nodes[id];
+    m_freeList = n.parent;
+    n.o = nullptr;
+    n.parent = nullNode;
+    n.child1 = nullNode;
+    n.child2 = nullNode;
+    n.height = 0;
+    return id;
+}
+
+void aabbTree::freeNode(int id) {
+    m_nodes[id].parent = m_freeList;
+    m_nodes[id].height = -1;
+    m_freeList = id;
+}
+
+int aabbTree::insert(object* o) {
+    return insert(o, o->getAABB());
+}
+
+int aabbTree::insert(object* o, const types::aabb<float>& box) {
+    const int id = allocateNode();
+    node& n = m_nodes[id];
+    n.box = {box.xmin - m_margin, box.ymin - m_margin, box.xmax + m_margin, box.ymax + m_margin};
+    n.o = o;
+    insertLeaf(id);
+    m_leafs++;
+    return id;
+}
+
+void aabbTree::remove(int id) {
+    removeLeaf(id);
+    freeNode(id);
+    m_leafs--;
+}
+
+bool aabbTree::move(int id, const types::aabb<float>& box, float dx, float dy) {
+    if (contains(m_nodes[id].box, box))
+        return false;
+
+    removeLeaf(id);
+    // enlarge the box by the margin and in the direction of the predicted movement
+    types::aabb<float> fat = {box.xmin - m_margin, box.ymin - m_margin, box.xmax + m_margin, box.ymax + m_margin};
+    const float px = m_displacementMultiplier * dx;
+    const float py = m_displacementMultiplier * dy;
+    if (px < 0)
+        fat.xmin += px;
+    else
+        fat.xmax += px;
+    if (py < 0)
+        fat.ymin += py;
+    else
+        fat.ymax += py;
+    m_nodes[id].box = fat;
+    insertLeaf(id);
+    return true;
+}
+
+object* aabbTree::getObject(int id) const {
+    return m_nodes[id].o;
+}
+
+const types::aabb<float>& aabbTree::getFatAABB(int id) const {
+    return m_nodes[id].box;
+}
+
+void aabbTree::clear() {
+    m_nodes.clear();
+    m_root = nullNode;
+    m_freeList = nullNode;
+    m_leafs = 0;
+}
+
+int aabbTree::size() const {
+    return m_leafs;
+}
+
+int aabbTree::height() const {
+    return m_root == nullNode ? -1 : m_nodes[m_root].height;
+}
+
+void aabbTree::insertLeaf(int leaf) {
+    if (m_root == nullNode) {
+        m_root = leaf;
+        m_nodes[leaf].parent = nullNode;
+        return;
+    }
+
+    // find the best sibling by the surface area heuristic (perimeter in 2D)
+    const types::aabb<float> leafBox = m_nodes[leaf].box;
+    int index = m_root;
+    while (!m_nodes[index].isLeaf()) {
+        const node& n = m_nodes[index];
+        const float area = perimeter(n.box);
+        const float combinedArea = perimeter(combine(n.box, leafBox));
+        // cost of creating a new parent for this node and the new leaf
+        const float cost = 2 * combinedArea;
+        // minimum cost of pushing the leaf further down the tree
+        const float inheritanceCost = 2 * (combinedArea - area);
+
+        auto descendCost = [&](int child) {
+            const node& c = m_nodes[child];
+            const float combined = perimeter(combine(leafBox, c.box));
+            return c.isLeaf() ? combined + inheritanceCost : combined - perimeter(c.box) + inheritanceCost;
+        };
+        const float cost1 = descendCost(n.child1);
+        const float cost2 = descendCost(n.child2);
+        if (cost < cost1 && cost < cost2)
+            break;
+        index = cost1 < cost2 ? n.child1 : n.child2;
+    }
+    const int sibling = index;
+
+    // create a new parent
+    const int oldParent = m_nodes[sibling].parent;
+    const int newParent = allocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].box = combine(leafBox, m_nodes[sibling].box);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+    if (oldParent != nullNode) {
+        if (m_nodes[oldParent].child1 == sibling)
+            m_nodes[oldParent].child1 = newParent;
+        else
+            m_nodes[oldParent].child2 = newParent;
+    } else {
+        m_root = newParent;
+    }
+
+    // walk back up the tree fixing heights and boxes
+    index = m_nodes[leaf].parent;
+    while (index != nullNode) {
+        index = balance(index);
+        node& n = m_nodes[index];
+        n.height = 1 + std::max(m_nodes[n.child1].height, m_nodes[n.child2].height);
+        n.box = combine(m_nodes[n.child1].box, m_nodes[n.child2].box);
+        index = n.parent;
+    }
+}
+
+void aabbTree::removeLeaf(int leaf) {
+    if (leaf == m_root) {
+        m_root = nullNode;
+        return;
+    }
+
+    const int parent = m_nodes[leaf].parent;
+    const int grandParent = m_nodes[parent].parent;
+    const int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+    if (grandParent != nullNode) {
+        // connect the sibling to the grand parent and destroy the parent
+        if (m_nodes[grandParent].child1 == parent)
+            m_nodes[grandParent].child1 = sibling;
+        else
+            m_nodes[grandParent].child2 = sibling;
+        m_nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        int index = grandParent;
+        while (index != nullNode) {
+            index = balance(index);
+            node& n = m_nodes[index];
+            n.box = combine(m_nodes[n.child1].box, m_nodes[n.child2].box);
+            n.height = 1 + std::max(m_nodes[n.child1].height, m_nodes[n.child2].height);
+            index = n.parent;
+        }
+    } else {
+        m_root = sibling;
+        m_nodes[sibling].parent = nullNode;
+        freeNode(parent);
+    }
+}
+
+int aabbTree::balance(int iA) {
+    node& A = m_nodes[iA];
+    if (A.isLeaf() || A.height < 2)
+        return iA;
+
+    const int iB = A.child1;
+    const int iC = A.child2;
+    node& B = m_nodes[iB];
+    node& C = m_nodes[iC];
+    const int difference = C.height - B.height;
+
+    auto replaceChild = [&](int parent, int oldChild, int newChild) {
+        if (parent == nullNode) {
+            m_root = newChild;
+        } else if (m_nodes[parent].child1 == oldChild) {
+            m_nodes[parent].child1 = newChild;
+        } else {
+            m_nodes[parent].child2 = newChild;
+        }
+    };
+
+    // rotate C up
+    if (difference > 1) {
+        const int iF = C.child1;
+        const int iG = C.child2;
+        node& F = m_nodes[iF];
+        node& G = m_nodes[iG];
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        replaceChild(C.parent, iA, iC);
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.box = combine(B.box, G.box);
+            C.box = combine(A.box, F.box);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        } else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.box = combine(B.box, F.box);
+            C.box = combine(A.box, G.box);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        return iC;
+    }
+
+    // rotate B up
+    if (difference < -1) {
+        const int iD = B.child1;
+        const int iE = B.child2;
+        node& D = m_nodes[iD];
+        node& E = m_nodes[iE];
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        replaceChild(B.parent, iA, iB);
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.box = combine(C.box, E.box);
+            B.box = combine(A.box, D.box);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        } else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.box = combine(C.box, D.box);
+            B.box = combine(A.box, E.box);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+std::pair<object*, float> aabbTree::nearest(const types::xypoint<float>& point, float maxDistance) const {
+    return nearest(point, maxDistance, [&point](const object* o) {
+        const float dx = o->x() - point.first;
+        const float dy = o->y() - point.second;
+        return std::max(std::sqrt(dx * dx + dy * dy) - o->radius(), 0.0f);
+    });
+}
+
+bool aabbTree::rayOverlaps(const types::aabb<float>& box, const types::xypoint<float>& origin, const types::xypoint<float>& direction, float maxFraction) {
+    float tmin = 0;
+    float tmax = maxFraction;
+    const float o[2] = {origin.first, origin.second};
+    const float d[2] = {direction.first, direction.second};
+    const float lower[2] = {box.xmin, box.ymin};
+    const float upper[2] = {box.xmax, box.ymax};
+    for (int axis = 0; axis < 2; ++axis) {
+        if (std::abs(d[axis]) < std::numeric_limits<float>::epsilon()) {
+            // parallel to the slab
+            if (o[axis] < lower[axis] || o[axis] > upper[axis])
+                return false;
+        } else {
+            const float inv = 1 / d[axis];
+            float t1 = (lower[axis] - o[axis]) * inv;
+            float t2 = (upper[axis] - o[axis]) * inv;
+            if (t1 > t2)
+                std::swap(t1, t2);
+            tmin = std::max(tmin, t1);
+            tmax = std::min(tmax, t2);
+            if (tmin > tmax)
+                return false;
+        }
+    }
+    return true;
+}
+
+types::aabb<float> aabbTree::combine(const types::aabb<float>& a, const types::aabb<float>& b) {
+    return {std::min(a.xmin, b.xmin), std::min(a.ymin, b.ymin), std::max(a.xmax, b.xmax), std::max(a.ymax, b.ymax)};
+}
+
+float aabbTree::perimeter(const types::aabb<float>& a) {
+    return 2 * ((a.xmax - a.xmin) + (a.ymax - a.ymin));
+}
+
+bool aabbTree::contains(const types::aabb<float>& outer, const types::aabb<float>& inner) {
+    return outer.xmin <= inner.xmin && outer.ymin <= inner.ymin && inner.xmax <= outer.xmax && inner.ymax <= outer.ymax;
+}
+
+collisionWorld::collisionWorld(float margin) : m_staticTree(0), m_dynamicTree(margin) {}
+
+int collisionWorld::add(object* o, bool isStatic) {
+    entry e = {o, isStatic ? m_staticTree.insert(o) : m_dynamicTree.insert(o), isStatic};
+    if (!m_freeHandles.empty()) {
+        const int handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+        m_entries[handle] = e;
+        return handle;
+    }
+    m_entries.push_back(e);
+    return static_cast<int>(m_entries.size()) - 1;
+}
+
+void collisionWorld::remove(int handle) {
+    entry& e = m_entries[handle];
+    if (!e.o)
+        return;
+    if (e.isStatic)
+        m_staticTree.remove(e.proxy);
+    else
+        m_dynamicTree.remove(e.proxy);
+    e.o = nullptr;
+    m_freeHandles.push_back(handle);
+}
+
+void collisionWorld::update(float dt) {
+    for (const entry& e : m_entries)
+        if (e.o && !e.isStatic)
+            m_dynamicTree.move(e.proxy, e.o->getAABB(), e.o->vx() * dt, e.o->vy() * dt);
+}
+
+void collisionWorld::queryPairs(std::vector<std::pair<object*, object*>>& pairs) const {
+    pairs.clear();
+    for (const entry& e : m_entries) {
+        if (!e.o || e.isStatic)
+            continue;
+        const types::aabb<float>& box = m_dynamicTree.getFatAABB(e.proxy);
+        // every dynamic pair is reported once (by the leaf with the smaller id)
+        m_dynamicTree.query(box, [&](object* other, int id) {
+            if (id > e.proxy)
+                pairs.push_back({e.o, other});
+            return true;
+        });
+        m_staticTree.query(box, [&](object* other, int) {
+            pairs.push_back({e.o, other});
+            return true;
+        });
+    }
+}
+
+std::pair<object*, float> collisionWorld::nearest(const types::xypoint<float>& point, float maxDistance) const {
+    const std::pair<object*, float> dynamicNearest = m_dynamicTree.nearest(point, maxDistance);
+    const std::pair<object*, float> staticNearest = m_staticTree.nearest(point, dynamicNearest.second);
+    return staticNearest.first ? staticNearest : dynamicNearest;
+}
+
+const aabbTree& collisionWorld::staticTree() const {
+    return m_staticTree;
+}
+
+const aabbTree& collisionWorld::dynamicTree() const {
+    return m_dynamicTree;
+}
\ No newline at end of file
@@ -0,0 +1,255 @@
+/*
+ *  bvh.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <vector>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include "object.h"
+#include "point.h"
+
+// Dynamic bounding volume hierarchy of axis aligned bounding boxes.
+// Every leaf stores an object together with a fat AABB (the tight AABB enlarged by a margin), so that
+// small movements of an object do not require an update of the tree. Inserting, removing and moving an
+// object as well as the queries run in O(log n) for a balanced tree.
+class aabbTree {
+public:
+    static constexpr int nullNode = -1;
+
+    // margin: the AABBs of the leafs are enlarged by this amount in every direction
+    // displacementMultiplier: moving leafs are additionally enlarged in the direction of movement
+    aabbTree(float margin = 2, float displacementMultiplier = 2);
+
+    // insert an object with its (tight) world space AABB, returns the id of the leaf
+    int insert(object* o, const types::aabb<float>& box);
+    int insert(object* o);
+
+    // remove a leaf
+    void remove(int id);
+
+    // update the AABB of a moved object. The leaf is only reinserted if the tight AABB left the fat AABB,
+    // dx, dy is the expected displacement until the next update. Returns true if the leaf was reinserted.
+    bool move(int id, const types::aabb<float>& box, float dx = 0, float dy = 0);
+
+    // the object and fat AABB of a leaf
+    object* getObject(int id) const;
+    const types::aabb<float>& getFatAABB(int id) const;
+
+    // remove all leafs
+    void clear();
+
+    // number of objects in the tree
+    int size() const;
+
+    // height of the tree (0 for a single leaf, -1 for an empty tree)
+    int height() const;
+
+    // call callback(object*, id) for every leaf whose fat AABB overlaps box.
+    // The query stops if callback returns false.
+    template<class F>
+    void query(const types::aabb<float>& box, F&& callback) const {
+        thread_local std::vector<int> stack;
+        stack.clear();
+        if (m_root != nullNode)
+            stack.push_back(m_root);
+        while (!stack.empty()) {
+            const int id = stack.back();
+            stack.pop_back();
+            const node& n = m_nodes[id];
+            if (!overlaps(n.box, box))
+                continue;
+            if (n.isLeaf()) {
+                if (!callback(n.o, id))
+                    return;
+            } else {
+                stack.push_back(n.child1);
+                stack.push_back(n.child2);
+            }
+        }
+    }
+
+    // cast the ray origin + t * direction, 0 <= t <= maxFraction through the tree.
+    // callback(object*, id, maxFraction) is called for every leaf whose fat AABB is hit and returns
+    // the new maxFraction: 0 terminates the raycast, a value < maxFraction clips the ray (e.g. to the
+    // hit of the object) and maxFraction continues unchanged.
+    template<class F>
+    void raycast(const types::xypoint<float>& origin, const types::xypoint<float>& direction, float maxFraction, F&& callback) const {
+        thread_local std::vector<int> stack;
+        stack.clear();
+        if (m_root != nullNode)
+            stack.push_back(m_root);
+        while (!stack.empty()) {
+            const int id = stack.back();
+            stack.pop_back();
+            const node& n = m_nodes[id];
+            if (!rayOverlaps(n.box, origin, direction, maxFraction))
+                continue;
+            if (n.isLeaf()) {
+                const float fraction = callback(n.o, id, maxFraction);
+                if (fraction <= 0)
+                    return;
+                maxFraction = std::min(maxFraction, fraction);
+            } else {
+                stack.push_back(n.child1);
+                stack.push_back(n.child2);
+            }
+        }
+    }
+
+    // the object closest to point within maxDistance, or nullptr.
+    // distance(object*) gives the exact distance of an object, the tree is searched best-first using
+    // the distance to the fat AABBs as a lower bound. Returns the object and its distance.
+    template<class F>
+    std::pair<object*, float> nearest(const types::xypoint<float>& point, float maxDistance, F&& distance) const {
+        thread_local std::vector<std::pair<float, int>> heap;
+        heap.clear();
+        std::pair<object*, float> best = {nullptr, maxDistance};
+        if (m_root == nullNode)
+            return best;
+        auto cmp = [](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first > b.first; };
+        heap.push_back({boxDistance(m_nodes[m_root].box, point), m_root});
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), cmp);
+            const std::pair<float, int> entry = heap.back();
+            heap.pop_back();
+            if (entry.first > best.second)
+                break;
+            const node& n = m_nodes[entry.second];
+            if (n.isLeaf()) {
+                const float d = distance(n.o);
+                if (d <= best.second)
+                    best = {n.o, d};
+                continue;
+            }
+            for (int child : {n.child1, n.child2}) {
+                const float d = boxDistance(m_nodes[child].box, point);
+                if (d <= best.second) {
+                    heap.push_back({d, child});
+                    std::push_heap(heap.begin(), heap.end(), cmp);
+                }
+            }
+        }
+        return best;
+    }
+
+    // the object closest to point, measured by the bounding circle of the objects
+    std::pair<object*, float> nearest(const types::xypoint<float>& point, float maxDistance = std::numeric_limits<float>::max()) const;
+
+    // true if two boxes overlap
+    static bool overlaps(const types::aabb<float>& a, const types::aabb<float>& b) {
+        return a.xmin <= b.xmax && b.xmin <= a.xmax && a.ymin <= b.ymax && b.ymin <= a.ymax;
+    }
+
+    // true if the ray origin + t * direction, 0 <= t <= maxFraction hits the box (slab test)
+    static bool rayOverlaps(const types::aabb<float>& box, const types::xypoint<float>& origin, const types::xypoint<float>& direction, float maxFraction);
+
+    // distance of a point to a box (0 if the point lies inside)
+    static float boxDistance(const types::aabb<float>& box, const types::xypoint<float>& point) {
+        const float dx = std::max({box.xmin - point.first, 0.0f, point.first - box.xmax});
+        const float dy = std::max({box.ymin - point.second, 0.0f, point.second - box.ymax});
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+private:
+    struct node {
+        types::aabb<float> box;
+        object* o;
+        // parent for nodes in the tree, next free node for nodes in the free list
+        int parent;
+        int child1;
+        int child2;
+        // leaf = 0, free node = -1
+        int height;
+
+        bool isLeaf() const {
+            return child1 == nullNode;
+        }
+    };
+
+    int allocateNode();
+    void freeNode(int id);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    // AVL rotation of the subtree at a, returns the new root of the subtree
+    int balance(int a);
+
+    static types::aabb<float> combine(const types::aabb<float>& a, const types::aabb<float>& b);
+    static float perimeter(const types::aabb<float>& a);
+    static bool contains(const types::aabb<float>& outer, const types::aabb<float>& inner);
+
+    std::vector<node> m_nodes;
+    int m_root;
+    int m_freeList;
+    int m_leafs;
+    float m_margin;
+    float m_displacementMultiplier;
+};
+
+// Collision world with separate trees for static and dynamic objects.
+// Static objects (walls, level geometry) are inserted once and never updated, the dynamic objects are
+// updated every frame by update(). Overlapping pairs are only searched between two dynamic objects and
+// between a dynamic and a static object.
+class collisionWorld {
+public:
+    collisionWorld(float margin = 2);
+
+    // add an object, returns a handle to remove it again.
+    // The object must stay valid (and must not be moved in memory) as long as it is part of the world.
+    int add(object* o, bool isStatic = false);
+    void remove(int handle);
+
+    // update the AABBs of all dynamic objects, dt is used to predict their displacement
+    void update(float dt = 0);
+
+    // all pairs of objects whose fat AABBs overlap (candidates for collision::checkCollision or collision::getContact)
+    void queryPairs(std::vector<std::pair<object*, object*>>& pairs) const;
+
+    // call callback(object*) for every object whose fat AABB overlaps box, stops if callback returns false
+    template<class F>
+    void query(const types::aabb<float>& box, F&& callback) const {
+        bool proceed = true;
+        auto cb = [&](object* o, int) { proceed = callback(o); return proceed; };
+        m_dynamicTree.query(box, cb);
+        if (proceed)
+            m_staticTree.query(box, cb);
+    }
+
+    // cast a ray through both trees, see aabbTree::raycast, callback(object*, maxFraction)
+    template<class F>
+    void raycast(const types::xypoint<float>& origin, const types::xypoint<float>& direction, float maxFraction, F&& callback) const {
+        bool terminated = false;
+        auto cb = [&](object* o, int, float fraction) {
+            const float result = callback(o, fraction);
+            if (result <= 0)
+                terminated = true;
+            else
+                maxFraction = std::min(maxFraction, result);
+            return result;
+        };
+        m_dynamicTree.raycast(origin, direction, maxFraction, cb);
+        if (!terminated)
+            m_staticTree.raycast(origin, direction, maxFraction, cb);
+    }
+
+    // the object closest to point (bounding circle distance)
+    std::pair<object*, float> nearest(const types::xypoint<float>& point, float maxDistance = std::numeric_limits<float>::max()) const;
+
+    const aabbTree& staticTree() const;
+    const aabbTree& dynamicTree() const;
+
+private:
+    struct entry {
+        object* o;
+        int proxy;
+        bool isStatic;
+    };
+
+    aabbTree m_staticTree;
+    aabbTree m_dynamicTree;
+    std::vector<entry> m_entries;
+    std::vector<int> m_freeHandles;
+};
\ No newline at end of file
@@ -3,13 +3,17 @@
 #include <math.h>
 #include <iostream>
 #include <climits>
+#include <algorithm>
+#include <limits>
+#include "profiler.h"
 
 bool collision::checkCollision(const object& o1, const object& o2) {
+    PROFILE_SCOPE("collision::checkCollision");
+    PROFILE_COUNT("pairs tested", 1);
     // if objects consists of no points, check their dimensions
     if (o1.npoints() == 0 && o2.npoints() == 0) {
-        float dim1 = dim(o1);
-        float dim2 = dim(o2);
-        if(dim1 + dim2 >= dist(o1, o2)) {
+        const float dim12 = dim(o1) + dim(o2);
+        if(dim12 * dim12 >= dist2(o1, o2)) {
           return true;
         } else {
           return false;
@@ -21,14 +25,14 @@ bool collision::checkCollision(const object& o1, const object& o2) {
         // then their distance from center to center -> enable advanced collision detection
         const float dim1 = dim(o1);
         const float dim2 = dim(o2);
-        if(dim1 + dim2 >= dist(o1, o2)) {
+        if((dim1 + dim2) * (dim1 + dim2) >= dist2(o1, o2)) {
             // advanced collision control
             if(dim1 <= dim2) {
                 // start of line between two points
                 types::point<float> start = o2.getCenter();
                 for (int i = 0; i < o2.npoints(); ++i) {
                     // end of line
-                    types::point<float> end = o2.getPoint(i);
+                    types::point<float> end = o2.getPointUnchecked(i);
                     // number of points on line
                     const int nsteps = (int)(10 * dist(start, end) / dim1);
                     for (int j = 0; j < nsteps; ++j) {
@@ -36,7 +40,7 @@ bool collision::checkCollision(const object& o1, const object& o2) {
                         float x = start.x + j * (end.x - start.x) / nsteps;
                         float y = start.y + j * (end.y - start.y) / nsteps;
                         types::xypoint<float> check = {x, y};
-                        if(dist(o1, check) <= dim1) collided = true;
+                        if(dist2(o1, check) <= o1.radiusSquare()) collided = true;
                     }
                     start = end;
                 }
@@ -45,7 +49,7 @@ bool collision::checkCollision(const object& o1, const object& o2) {
                 types::point<float> start = o1.getCenter();
                 for (int i = 0; i < o1.npoints(); ++i) {
                     // end of line
-                    types::point<float> end = o1.getPoint(i);
+                    types::point<float> end = o1.getPointUnchecked(i);
                     // number of points on line
                     const int nsteps = (int)(10 * dist(start, end) / dim2);
                     for (int j = 0; j < nsteps; ++j) {
@@ -53,7 +57,7 @@ bool collision::checkCollision(const object& o1, const object& o2) {
                         float x = start.x + j * (end.x - start.x) / nsteps;
                         float y = start.y + j * (end.y - start.y) / nsteps;
                         types::xypoint<float> check = {x, y};
-                        if(dist(o2, check) <= dim2) collided = true;
+                        if(dist2(o2, check) <= o2.radiusSquare()) collided = true;
                     }
                     start = end;
                 }
@@ -71,6 +75,18 @@ float collision::dist(const object& o1, const object& o2) {
     return dist;
 }
 
+float collision::dist2(const object& o1, const object& o2) {
+    const float dx = o1.x() - o2.x();
+    const float dy = o1.y() - o2.y();
+    return dx * dx + dy * dy;
+}
+
+float collision::dist2(const object& o, const types::xypoint<float>& point) {
+    const float dx = o.x() - point.first;
+    const float dy = o.y() - point.second;
+    return dx * dx + dy * dy;
+}
+
 float collision::dist(const object& o, const types::xypoint<float>& point) {
     const types::xypoint<float>& cen = o.getCenterXY();
     const float dist = sqrt(pow(cen.first - point.first, 2) + pow(cen.second - point.second, 2));
@@ -89,20 +105,388 @@ float collision::dist(const types::point<float>& point0, const types::point<floa
 }
 
 float collision::dim(const object& o) {
-    if (o.npoints() == 0) {
-        return o.hsize() / 2;
-    } else {
-        types::xypoint<float> r0 = o.getCenterXY();
-        float rAbs = 0;
-        for(int i = 0; i < o.npoints(); ++i) {
-            if(o.isCollidable(i)) {
-                types::point<float> r = o.getPoint(i);
-                float x = r.x - r0.first;
-                float y = r.y - r0.second;
-                if(rAbs <= sqrt(pow(x, 2) + pow(y, 2)))
-                    rAbs = sqrt(pow(x, 2) + pow(y, 2));
+    return o.radius();
+}
+
+namespace {
+    inline float dot(const types::xypoint<float>& a, const types::xypoint<float>& b) {
+        return a.first * b.first + a.second * b.second;
+    }
+
+    inline float cross(const types::xypoint<float>& a, const types::xypoint<float>& b) {
+        return a.first * b.second - a.second * b.first;
+    }
+
+    inline types::xypoint<float> sub(const types::xypoint<float>& a, const types::xypoint<float>& b) {
+        return {a.first - b.first, a.second - b.second};
+    }
+
+    // outward normal of the edge a -> b of a counter clockwise polygon
+    inline types::xypoint<float> edgeNormal(const types::xypoint<float>& a, const types::xypoint<float>& b) {
+        const float dx = b.first - a.first;
+        const float dy = b.second - a.second;
+        const float len = std::sqrt(dx * dx + dy * dy);
+        if (len <= 0)
+            return {0, 0};
+        return {dy / len, -dx / len};
+    }
+
+    // the largest separation of polygon b from the edges of polygon a
+    float maxSeparation(const std::vector<types::xypoint<float>>& a, const std::vector<types::xypoint<float>>& b, int& edge) {
+        float best = -std::numeric_limits<float>::max();
+        edge = 0;
+        const int n = static_cast<int>(a.size());
+        for (int i = 0; i < n; ++i) {
+            const types::xypoint<float> normal = edgeNormal(a[i], a[(i + 1) % n]);
+            float separation = std::numeric_limits<float>::max();
+            for (const types::xypoint<float>& v : b)
+                separation = std::min(separation, dot(normal, sub(v, a[i])));
+            if (separation > best) {
+                best = separation;
+                edge = i;
+            }
+        }
+        return best;
+    }
+
+    // keep the part of the segment (p[0], p[1]) with dot(direction, p) <= offset
+    int clipSegment(std::array<types::xypoint<float>, 2>& p, const types::xypoint<float>& direction, float offset) {
+        const float d0 = dot(direction, p[0]) - offset;
+        const float d1 = dot(direction, p[1]) - offset;
+        if (d0 > 0 && d1 > 0)
+            return 0;
+        if (d0 * d1 < 0) {
+            const float t = d0 / (d0 - d1);
+            const types::xypoint<float> q = {p[0].first + t * (p[1].first - p[0].first), p[0].second + t * (p[1].second - p[0].second)};
+            if (d0 > 0)
+                p[0] = q;
+            else
+                p[1] = q;
+        }
+        return 2;
+    }
+}
+
+void collision::polygon(const object& o, std::vector<types::xypoint<float>>& poly) {
+    poly.clear();
+    const types::point<float>* points = o.localPoints();
+    const types::xypoint<float> center = o.getCenterXY();
+    for (int i = 0; i < o.npoints(); ++i)
+        if (points[i].iscollidable)
+            poly.push_back({points[i].x + center.first, points[i].y + center.second});
+    // closed outlines repeat the first point
+    if (poly.size() > 2 && poly.front() == poly.back())
+        poly.pop_back();
+
+    float area = 0;
+    for (size_t i = 0; i < poly.size(); ++i)
+        area += cross(poly[i], poly[(i + 1) % poly.size()]);
+    if (area < 0)
+        std::reverse(poly.begin(), poly.end());
+}
+
+bool collision::circleContact(const types::xypoint<float>& c1, float r1, const types::xypoint<float>& c2, float r2, contact& c) {
+    const types::xypoint<float> d = sub(c2, c1);
+    const float distSquare = dot(d, d);
+    if (distSquare > (r1 + r2) * (r1 + r2))
+        return false;
+    const float distance = std::sqrt(distSquare);
+    c.normal = distance > 0 ? types::xypoint<float>{d.first / distance, d.second / distance} : types::xypoint<float>{1, 0};
+    c.depth = r1 + r2 - distance;
+    const float s = r1 - c.depth / 2;
+    c.points[0] = {c1.first + c.normal.first * s, c1.second + c.normal.second * s};
+    c.npoints = 1;
+    return true;
+}
+
+bool collision::circlePolygonContact(const types::xypoint<float>& center, float r, const std::vector<types::xypoint<float>>& poly, contact& c) {
+    const int n = static_cast<int>(poly.size());
+    float best = -std::numeric_limits<float>::max();
+    int edge = 0;
+    for (int i = 0; i < n; ++i) {
+        const float separation = dot(edgeNormal(poly[i], poly[(i + 1) % n]), sub(center, poly[i]));
+        if (separation > r)
+            return false;
+        if (separation > best) {
+            best = separation;
+            edge = i;
+        }
+    }
+
+    if (best < 0) {
+        // the center lies inside of the polygon
+        const types::xypoint<float> normal = edgeNormal(poly[edge], poly[(edge + 1) % n]);
+        c.normal = {-normal.first, -normal.second};
+        c.depth = r - best;
+        c.points[0] = {center.first - normal.first * best, center.second - normal.second * best};
+        c.npoints = 1;
+        return true;
+    }
+
+    // closest point of the polygon outline
+    float minDistSquare = std::numeric_limits<float>::max();
+    types::xypoint<float> closest = poly[0];
+    for (int i = 0; i < n; ++i) {
+        const types::xypoint<float>& a = poly[i];
+        const types::xypoint<float> ab = sub(poly[(i + 1) % n], a);
+        const float len2 = dot(ab, ab);
+        const float t = len2 > 0 ? std::min(std::max(dot(sub(center, a), ab) / len2, 0.0f), 1.0f) : 0;
+        const types::xypoint<float> q = {a.first + t * ab.first, a.second + t * ab.second};
+        const types::xypoint<float> d = sub(center, q);
+        if (dot(d, d) < minDistSquare) {
+            minDistSquare = dot(d, d);
+            closest = q;
+        }
+    }
+    if (minDistSquare > r * r)
+        return false;
+    const float distance = std::sqrt(minDistSquare);
+    c.normal = distance > 0 ? types::xypoint<float>{(closest.first - center.first) / distance, (closest.second - center.second) / distance} : types::xypoint<float>{1, 0};
+    c.depth = r - distance;
+    c.points[0] = closest;
+    c.npoints = 1;
+    return true;
+}
+
+bool collision::polygonContact(const std::vector<types::xypoint<float>>& poly1, const std::vector<types::xypoint<float>>& poly2, contact& c) {
+    int edge1, edge2;
+    const float separation1 = maxSeparation(poly1, poly2, edge1);
+    if (separation1 > 0)
+        return false;
+    const float separation2 = maxSeparation(poly2, poly1, edge2);
+    if (separation2 > 0)
+        return false;
+
+    // the reference edge is the edge of least penetration, prefer the first polygon to avoid flip-flopping
+    const bool flip = separation2 > separation1 + 0.01f * std::abs(separation1);
+    const std::vector<types::xypoint<float>>& ref = flip ? poly2 : poly1;
+    const std::vector<types::xypoint<float>>& inc = flip ? poly1 : poly2;
+    const int edge = flip ? edge2 : edge1;
+    const types::xypoint<float>& v1 = ref[edge];
+    const types::xypoint<float>& v2 = ref[(edge + 1) % ref.size()];
+    const types::xypoint<float> normal = edgeNormal(v1, v2);
+    const types::xypoint<float> tangent = {-normal.second, normal.first};
+
+    // incident edge: the edge of the other polygon that is most anti-parallel to the reference normal
+    int incident = 0;
+    float minDot = std::numeric_limits<float>::max();
+    const int n = static_cast<int>(inc.size());
+    for (int i = 0; i < n; ++i) {
+        const float d = dot(edgeNormal(inc[i], inc[(i + 1) % n]), normal);
+        if (d < minDot) {
+            minDot = d;
+            incident = i;
+        }
+    }
+
+    // clip the incident edge to the side planes of the reference edge
+    std::array<types::xypoint<float>, 2> clipped = {inc[incident], inc[(incident + 1) % n]};
+    if (clipSegment(clipped, {-tangent.first, -tangent.second}, -dot(tangent, v1)) < 2)
+        return false;
+    if (clipSegment(clipped, tangent, dot(tangent, v2)) < 2)
+        return false;
+
+    c.npoints = 0;
+    c.depth = 0;
+    for (const types::xypoint<float>& p : clipped) {
+        const float separation = dot(normal, sub(p, v1));
+        if (separation <= 0) {
+            c.points[c.npoints++] = p;
+            c.depth = std::max(c.depth, -separation);
+        }
+    }
+    if (c.npoints == 0)
+        return false;
+    c.normal = flip ? types::xypoint<float>{-normal.first, -normal.second} : normal;
+    return true;
+}
+
+bool collision::getContact(const object& o1, const object& o2, contact& c) {
+    const float dim1 = dim(o1);
+    const float dim2 = dim(o2);
+    if ((dim1 + dim2) * (dim1 + dim2) < dist2(o1, o2))
+        return false;
+
+    thread_local std::vector<types::xypoint<float>> poly1, poly2;
+    polygon(o1, poly1);
+    polygon(o2, poly2);
+    const bool circle1 = poly1.size() < 2;
+    const bool circle2 = poly2.size() < 2;
+    if (circle1 && circle2)
+        return circleContact(o1.getCenterXY(), dim1, o2.getCenterXY(), dim2, c);
+    if (circle1)
+        return circlePolygonContact(o1.getCenterXY(), dim1, poly2, c);
+    if (circle2) {
+        if (!circlePolygonContact(o2.getCenterXY(), dim2, poly1, c))
+            return false;
+        c.normal = {-c.normal.first, -c.normal.second};
+        return true;
+    }
+    return polygonContact(poly1, poly2, c);
+}
+
+void collision::findContacts(const std::vector<object*>& objects, std::vector<contactPair>& contacts) {
+    contacts.clear();
+    contact c;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        for (size_t j = i + 1; j < objects.size(); ++j) {
+            if (objects[i]->invMass() == 0 && objects[j]->invMass() == 0)
+                continue;
+            if (getContact(*objects[i], *objects[j], c))
+                contacts.push_back({objects[i], objects[j], c, {0, 0}, {0, 0}});
+        }
+    }
+}
+
+void collision::findContacts(const std::vector<object*>& objects, std::vector<contactPair>& contacts, jobSystem& jobs) {
+    // one buffer per thread, the key i * n + j restores the order of the serial version
+    thread_local std::vector<std::vector<std::pair<size_t, contactPair>>> threadBuffers;
+    // the workers must write to the buffers of the calling thread, not to their own thread_local instance
+    std::vector<std::vector<std::pair<size_t, contactPair>>>& buffers = threadBuffers;
+    buffers.resize(jobs.numberOfThreads());
+    for (auto& buffer : buffers)
+        buffer.clear();
+    const size_t n = objects.size();
+    // the rows get shorter with i, small chunks let the threads balance the work by stealing
+    jobs.parallelFor(0, n, 4, [&](size_t begin, size_t end, unsigned int thread) {
+        contact c;
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t j = i + 1; j < n; ++j) {
+                if (objects[i]->invMass() == 0 && objects[j]->invMass() == 0)
+                    continue;
+                if (getContact(*objects[i], *objects[j], c))
+                    buffers[thread].push_back({i * n + j, {objects[i], objects[j], c, {0, 0}, {0, 0}}});
             }
         }
-        return rAbs;
+    });
+    mergeContacts(buffers, contacts);
+}
+
+void collision::findContacts(const std::vector<std::pair<object*, object*>>& pairs, std::vector<contactPair>& contacts, jobSystem& jobs) {
+    thread_local std::vector<std::vector<std::pair<size_t, contactPair>>> threadBuffers;
+    // the workers must write to the buffers of the calling thread, not to their own thread_local instance
+    std::vector<std::vector<std::pair<size_t, contactPair>>>& buffers = threadBuffers;
+    buffers.resize(jobs.numberOfThreads());
+    for (auto& buffer : buffers)
+        buffer.clear();
+    jobs.parallelFor(0, pairs.size(), 64, [&](size_t begin, size_t end, unsigned int thread) {
+        contact c;
+        for (size_t k = begin; k < end; ++k) {
+            object* o1 = pairs[k].first;
+            object* o2 = pairs[k].second;
+            if (o1->invMass() == 0 && o2->invMass() == 0)
+                continue;
+            if (getContact(*o1, *o2, c))
+                buffers[thread].push_back({k, {o1, o2, c, {0, 0}, {0, 0}}});
+        }
+    });
+    mergeContacts(buffers, contacts);
+}
+
+void collision::mergeContacts(std::vector<std::vector<std::pair<size_t, contactPair>>>& buffers, std::vector<contactPair>& contacts) {
+    thread_local std::vector<std::pair<size_t, contactPair>> merged;
+    merged.clear();
+    for (const auto& buffer : buffers)
+        merged.insert(merged.end(), buffer.begin(), buffer.end());
+    std::sort(merged.begin(), merged.end(), [](const std::pair<size_t, contactPair>& a, const std::pair<size_t, contactPair>& b) { return a.first < b.first; });
+    contacts.clear();
+    for (const auto& entry : merged)
+        contacts.push_back(entry.second);
+}
+
+float collision::invInertia(const object& o) {
+    const float r = dim(o);
+    if (o.mass() <= 0 || r <= 0)
+        return 0;
+    return 2 / (o.mass() * r * r);
+}
+
+void collision::resolveContacts(std::vector<contactPair>& contacts) {
+    resolveContacts(contacts, resolverParameters());
+}
+
+void collision::resolveContacts(std::vector<contactPair>& contacts, const resolverParameters& parameters) {
+    // restitution: separating velocity the contacts should reach, taken from the velocities before the resolution
+    thread_local std::vector<std::array<float, 2>> bias;
+    bias.resize(contacts.size());
+    for (size_t k = 0; k < contacts.size(); ++k) {
+        contactPair& cp = contacts[k];
+        cp.normalImpulse = {0, 0};
+        cp.tangentImpulse = {0, 0};
+        for (int p = 0; p < cp.c.npoints; ++p) {
+            const types::xypoint<float> rA = sub(cp.c.points[p], cp.o1->getCenterXY());
+            const types::xypoint<float> rB = sub(cp.c.points[p], cp.o2->getCenterXY());
+            const types::xypoint<float> dv = {cp.o2->vx() - cp.o2->spin() * rB.second - cp.o1->vx() + cp.o1->spin() * rA.second,
+                                              cp.o2->vy() + cp.o2->spin() * rB.first - cp.o1->vy() - cp.o1->spin() * rA.first};
+            const float vn = dot(dv, cp.c.normal);
+            bias[k][p] = vn < 0 ? -parameters.restitution * vn : 0;
+        }
     }
-}
\ No newline at end of file
+
+    for (int iteration = 0; iteration < parameters.iterations; ++iteration) {
+        for (size_t k = 0; k < contacts.size(); ++k) {
+            contactPair& cp = contacts[k];
+            object& a = *cp.o1;
+            object& b = *cp.o2;
+            const float invMassA = a.invMass();
+            const float invMassB = b.invMass();
+            const float invIA = invInertia(a);
+            const float invIB = invInertia(b);
+            const types::xypoint<float>& n = cp.c.normal;
+            const types::xypoint<float> t = {-n.second, n.first};
+
+            for (int p = 0; p < cp.c.npoints; ++p) {
+                const types::xypoint<float> rA = sub(cp.c.points[p], a.getCenterXY());
+                const types::xypoint<float> rB = sub(cp.c.points[p], b.getCenterXY());
+                float vxA = a.vx(), vyA = a.vy(), wA = a.spin();
+                float vxB = b.vx(), vyB = b.vy(), wB = b.spin();
+
+                // normal impulse
+                types::xypoint<float> dv = {vxB - wB * rB.second - vxA + wA * rA.second, vyB + wB * rB.first - vyA - wA * rA.first};
+                const float rnA = cross(rA, n);
+                const float rnB = cross(rB, n);
+                const float kNormal = invMassA + invMassB + invIA * rnA * rnA + invIB * rnB * rnB;
+                if (kNormal <= 0)
+                    continue;
+                float lambda = (bias[k][p] - dot(dv, n)) / kNormal;
+                const float oldNormal = cp.normalImpulse[p];
+                cp.normalImpulse[p] = std::max(oldNormal + lambda, 0.0f);
+                lambda = cp.normalImpulse[p] - oldNormal;
+                types::xypoint<float> P = {lambda * n.first, lambda * n.second};
+                vxA -= invMassA * P.first; vyA -= invMassA * P.second; wA -= invIA * cross(rA, P);
+                vxB += invMassB * P.first; vyB += invMassB * P.second; wB += invIB * cross(rB, P);
+
+                // friction impulse
+                dv = {vxB - wB * rB.second - vxA + wA * rA.second, vyB + wB * rB.first - vyA - wA * rA.first};
+                const float rtA = cross(rA, t);
+                const float rtB = cross(rB, t);
+                const float kTangent = invMassA + invMassB + invIA * rtA * rtA + invIB * rtB * rtB;
+                lambda = -dot(dv, t) / kTangent;
+                const float maxFriction = parameters.friction * cp.normalImpulse[p];
+                const float oldTangent = cp.tangentImpulse[p];
+                cp.tangentImpulse[p] = std::min(std::max(oldTangent + lambda, -maxFriction), maxFriction);
+                lambda = cp.tangentImpulse[p] - oldTangent;
+                P = {lambda * t.first, lambda * t.second};
+                vxA -= invMassA * P.first; vyA -= invMassA * P.second; wA -= invIA * cross(rA, P);
+                vxB += invMassB * P.first; vyB += invMassB * P.second; wB += invIB * cross(rB, P);
+
+                a.setv(vxA, vyA);
+                a.setSpin(wA);
+                b.setv(vxB, vyB);
+                b.setSpin(wB);
+            }
+        }
+    }
+
+    // position correction: push the objects apart along the normal, proportional to their inverse masses
+    for (contactPair& cp : contacts) {
+        const float invMassA = cp.o1->invMass();
+        const float invMassB = cp.o2->invMass();
+        if (invMassA + invMassB <= 0)
+            continue;
+        const float correction = std::max(cp.c.depth - parameters.slop, 0.0f) * parameters.correction / (invMassA + invMassB);
+        const types::xypoint<float>& n = cp.c.normal;
+        cp.o1->setPos(cp.o1->x() - invMassA * correction * n.first, cp.o1->y() - invMassA * correction * n.second);
+        cp.o2->setPos(cp.o2->x() + invMassB * correction * n.first, cp.o2->y() + invMassB * correction * n.second);
+    }
+}
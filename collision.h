@@ -5,8 +5,12 @@
  */
 #pragma once
 #include <tuple>
+#include <array>
+#include <vector>
+#include <utility>
 #include "object.h"
 #include "point.h"
+#include "jobs.h"
 
 class collision {
 public:
@@ -15,9 +19,63 @@ public:
     //Note: the points should form an convex object at best
     static bool checkCollision(const object& o1, const object& o2);
 
+    // contact information of two colliding objects
+    struct contact {
+        // unit normal pointing from the first to the second object
+        types::xypoint<float> normal;
+        // penetration depth along the normal
+        float depth;
+        // contact points in world coordinates (one or two)
+        std::array<types::xypoint<float>, 2> points;
+        int npoints;
+    };
+
+    // a contact between two objects together with the impulses accumulated by the resolver
+    struct contactPair {
+        object* o1;
+        object* o2;
+        contact c;
+        std::array<float, 2> normalImpulse;
+        std::array<float, 2> tangentImpulse;
+    };
+
+    // parameters of the sequential impulse resolver
+    struct resolverParameters {
+        // number of velocity iterations, the resolver always does exactly this many
+        int iterations = 8;
+        // coefficient of restitution (0: inelastic, 1: elastic)
+        float restitution = 0;
+        // coulomb friction coefficient
+        float friction = 0.3;
+        // fraction of the penetration that is removed by the position correction
+        float correction = 0.2;
+        // allowed penetration that is not corrected (avoids jitter of resting contacts)
+        float slop = 0.5;
+    };
+
+    // computes the contact of two objects. Objects without points are treated as circles with
+    // diameter hsize, objects with points as convex polygons formed by their collidable points.
+    // returns false if the objects do not overlap
+    static bool getContact(const object& o1, const object& o2, contact& c);
+
+    // collects the contacts of all pairs of objects, pairs of two static objects (mass 0) are skipped
+    static void findContacts(const std::vector<object*>& objects, std::vector<contactPair>& contacts);
+
+    // the same, but the pairs are tested in parallel. The contacts are in the same order as in the serial version.
+    static void findContacts(const std::vector<object*>& objects, std::vector<contactPair>& contacts, jobSystem& jobs);
+
+    // collects the contacts of a list of candidate pairs (e.g. from collisionWorld::queryPairs) in parallel,
+    // in the order of the pairs
+    static void findContacts(const std::vector<std::pair<object*, object*>>& pairs, std::vector<contactPair>& contacts, jobSystem& jobs = jobSystem::instance());
+
+    // resolves the contacts with sequential impulses and updates the velocities and spins
+    // (object::setv, object::setSpin) and corrects the positions of the objects
+    static void resolveContacts(std::vector<contactPair>& contacts, const resolverParameters& parameters);
+    static void resolveContacts(std::vector<contactPair>& contacts);
+
 private:    
     //returns the length of the largest distance from center
-    //this assumed to be the dimension of the object
+    //this assumed to be the dimension of the object (cached by the object)
     static float dim(const object& o);
     
     //calculate the distance of two objects
@@ -25,4 +83,22 @@ private:
     static float dist(const object& o, const types::point<float>& point);
     static float dist(const object& o, const types::xypoint<float>& point);
     static float dist(const types::point<float>& point0, const types::point<float>& point1);
+
+    //calculate the squared distance of two objects (no sqrt, used for the early-out tests)
+    static float dist2(const object& o1, const object& o2);
+    static float dist2(const object& o, const types::xypoint<float>& point);
+
+    // the collidable points of an object in world coordinates with counter clockwise winding
+    static void polygon(const object& o, std::vector<types::xypoint<float>>& poly);
+
+    // contact of two circles, of a circle and a polygon and of two polygons
+    static bool circleContact(const types::xypoint<float>& c1, float r1, const types::xypoint<float>& c2, float r2, contact& c);
+    static bool circlePolygonContact(const types::xypoint<float>& center, float r, const std::vector<types::xypoint<float>>& poly, contact& c);
+    static bool polygonContact(const std::vector<types::xypoint<float>>& poly1, const std::vector<types::xypoint<float>>& poly2, contact& c);
+
+    // moment of inertia of an object approximated by a disc with the object dimension as radius
+    static float invInertia(const object& o);
+
+    // merges the contacts found by the threads of a job system, sorted by their key
+    static void mergeContacts(std::vector<std::vector<std::pair<size_t, contactPair>>>& buffers, std::vector<contactPair>& contacts);
 };
\ No newline at end of file
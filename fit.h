@@ -6,6 +6,14 @@
 #pragma once
 #include "vector.h"
 #include "matrix.h"
+#include "parallel.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
 
 namespace math::utilities
 {
@@ -32,15 +40,141 @@ namespace math::utilities
             return x;
         }
 
+        /// <summary>
+        /// Solves b = A * x like above, but writes the result to x. The decomposition is kept in a
+        /// thread local workspace, so repeated calls with systems of the same shape do not allocate.
+        /// </summary>
         template<typename T>
         static int linFit(const vector<T>& b, const matrix<T>& A, vector<T>& x) {
-            if (A.rows() == 0 || A.cols() == 0 || b.size() == 0)
-                return -1;
-
-            x = vector<T>(A.eigen().colPivHouseholderQr().solve(b.eigen()));
-            return 0;
+            PROFILE_SCOPE("fit::linFit");
+            thread_local workspace<T> ws;
+            return ws.solve(b, A, x);
         }
 
+        /// <summary>
+        /// decompositions that can be used to solve b = A * x
+        /// colPivHouseholderQr: QR decomposition with column pivoting, robust, handles rank deficient A (default)
+        /// householderQr:       QR decomposition without pivoting, faster, A must have full rank
+        /// normalLlt:           Cholesky decomposition of the normal equations A^T A x = A^T b, fastest for
+        ///                      numberOfEquations >> numberOfUnknowns, but squares the condition number of A
+        /// </summary>
+        enum class solverType {
+            colPivHouseholderQr,
+            householderQr,
+            normalLlt
+        };
+
+        /// <summary>
+        /// Workspace for solving many least squares problems b = A * x one after another.
+        /// The decomposition and all intermediate buffers are kept between calls and are only reallocated if
+        /// the shape of A changes. The solution is written into a vector provided by the caller.
+        /// math::utilities::fit::workspace<double> ws(math::utilities::fit::solverType::householderQr);
+        /// ws.solve(b, A, x);
+        /// </summary>
+        template<typename T>
+        class workspace
+        {
+        public:
+            using eigen_matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+            using eigen_vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+            workspace(solverType solver = solverType::colPivHouseholderQr)
+                : m_solver(solver) {}
+
+            /// <summary>
+            /// the decomposition used by solve()
+            /// </summary>
+            solverType solver() const {
+                return m_solver;
+            }
+
+            void setSolver(solverType solver) {
+                m_solver = solver;
+            }
+
+            /// <summary>
+            /// solve b = A * x in the least squares sense, x is resized if needed
+            /// returns 0 on success, -1 if the system is empty or inconsistent, -2 if the decomposition failed
+            /// </summary>
+            int solve(const vector<T>& b, const matrix<T>& A, vector<T>& x) {
+                if (A.rows() == 0 || A.cols() == 0 || b.size() != A.rows())
+                    return -1;
+
+                const Eigen::Index n = A.rows();
+                const Eigen::Index k = A.cols();
+                m_x.resize(k);
+                int result = 0;
+                switch (m_solver) {
+                    case solverType::colPivHouseholderQr:
+                        result = solveColPivQr(b, A);
+                        break;
+                    case solverType::householderQr:
+                        result = solveQr(b, A, n, k);
+                        break;
+                    case solverType::normalLlt:
+                        result = solveLlt(b, A, k);
+                        break;
+                }
+                if (result != 0)
+                    return result;
+
+                if (x.size() != static_cast<size_t>(k))
+                    x.resize(k);
+                x.eigen() = m_x;
+                return 0;
+            }
+
+        private:
+            int solveColPivQr(const vector<T>& b, const matrix<T>& A) {
+                m_colPivQr.compute(A.eigen());
+                const Eigen::Index rank = m_colPivQr.nonzeroPivots();
+                m_rhs = b.eigen();
+                m_work.resize(1);
+                m_colPivQr.householderQ().setLength(rank).transpose().applyThisOnTheLeft(m_rhs, m_work);
+                m_colPivQr.matrixQR().topLeftCorner(rank, rank).template triangularView<Eigen::Upper>().solveInPlace(m_rhs.head(rank));
+                // undo the column permutation, the unknowns that belong to zero pivots are set to zero
+                const auto& permutation = m_colPivQr.colsPermutation().indices();
+                for (Eigen::Index i = 0; i < rank; ++i)
+                    m_x(permutation(i)) = m_rhs(i);
+                for (Eigen::Index i = rank; i < m_x.size(); ++i)
+                    m_x(permutation(i)) = 0;
+                return 0;
+            }
+
+            int solveQr(const vector<T>& b, const matrix<T>& A, Eigen::Index n, Eigen::Index k) {
+                if (n < k)
+                    return -1;
+                m_qr.compute(A.eigen());
+                m_rhs = b.eigen();
+                m_work.resize(1);
+                m_qr.householderQ().setLength(k).transpose().applyThisOnTheLeft(m_rhs, m_work);
+                m_qr.matrixQR().topLeftCorner(k, k).template triangularView<Eigen::Upper>().solveInPlace(m_rhs.head(k));
+                m_x = m_rhs.head(k);
+                return 0;
+            }
+
+            int solveLlt(const vector<T>& b, const matrix<T>& A, Eigen::Index k) {
+                m_normal.resize(k, k);
+                m_normal.setZero();
+                m_normal.template selfadjointView<Eigen::Lower>().rankUpdate(A.eigen().transpose());
+                m_x.noalias() = A.eigen().transpose() * b.eigen();
+                m_llt.compute(m_normal);
+                if (m_llt.info() != Eigen::Success)
+                    return -2;
+                m_llt.solveInPlace(m_x);
+                return 0;
+            }
+
+            solverType m_solver;
+            Eigen::ColPivHouseholderQR<eigen_matrix> m_colPivQr;
+            Eigen::HouseholderQR<eigen_matrix> m_qr;
+            Eigen::LLT<eigen_matrix> m_llt;
+            eigen_matrix m_normal; // A^T A
+            eigen_vector m_rhs; // Q^T b
+            eigen_vector m_work; // workspace of the householder reflections
+            eigen_vector m_x;
+        };
+
         /// <summary>
         /// Fit a polynom of degree "degree" to a given number of points.
         /// The matrix "points" can be generated as follows, for example:
@@ -61,21 +195,522 @@ namespace math::utilities
         /// </return>
         template<typename T>
         static math::vector<T> polyFit(const matrix<T>& points, size_t degree) {
-            const size_t numberOfPoints = points.rows();
+            // A is the coefficient matrix of the polynom
+            math::matrix<T> A;
+            math::vector<T> b;
+            polyMatrix(points, degree, A, b);
+
+            // Solve the equation b = A * x for x -> gives the coefficient of the polynomial 
+            // P_n(x) = c0 + c1 * x + c2 * x^2 + ...
+            return linFit<T>(b, A);
+        }
 
-             // A is the coefficient matrix of the polynom
-            math::matrix<double> A(numberOfPoints, degree + 1);
-            math::vector<double> b(numberOfPoints);
+        /// <summary>
+        /// Build the coefficient matrix A (A(i, j) = x_i^j) and the right hand side b (b_i = y_i) of a polynomial fit
+        /// of degree "degree" to the points (x_i, y_i) stored in the rows of "points".
+        /// A and b are only reallocated if their size changes.
+        /// </summary>
+        template<typename T>
+        static void polyMatrix(const matrix<T>& points, size_t degree, matrix<T>& A, vector<T>& b) {
+            const size_t numberOfPoints = points.rows();
+            if (A.rows() != numberOfPoints || A.cols() != degree + 1)
+                A.resize(numberOfPoints, degree + 1);
+            if (b.size() != numberOfPoints)
+                b.resize(numberOfPoints);
             for (size_t i = 0; i < numberOfPoints; ++i) { // for every vector
+                T power = 1;
                 for (size_t j = 0; j <= degree; ++j) { // for every coefficient (degree)
-                    A(i, j) = std::pow(points(i, 0), j);
+                    A(i, j) = power;
+                    power *= points(i, 0);
                 }
                 b[i] = points(i, 1);
             }
+        }
 
-            // Solve the equation b = A * x for x -> gives the coefficient of the polynomial 
-            // P_n(x) = c0 + c1 * x + c2 * x^2 + ...
-            return linFit<T>(b, A);
+        /// <summary>
+        /// Weighted least squares: minimizes sum w_i * (b_i - A_i * x)^2 with weights w_i >= 0.
+        /// The rows of A and b are scaled by sqrt(w_i) and the scaled system is solved with a QR decomposition.
+        /// </summary>
+        template<typename T>
+        static int weightedLinFit(const vector<T>& b, const matrix<T>& A, const vector<T>& w, vector<T>& x) {
+            if (A.rows() == 0 || A.cols() == 0 || b.size() != A.rows() || w.size() != A.rows())
+                return -1;
+
+            using eigen_matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+            using eigen_vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+            const eigen_vector sqrtw = w.eigen().cwiseMax(T(0)).cwiseSqrt();
+            const eigen_matrix Aw = sqrtw.asDiagonal() * A.eigen();
+            const eigen_vector bw = sqrtw.cwiseProduct(b.eigen());
+            x = vector<T>(eigen_vector(Aw.colPivHouseholderQr().solve(bw)));
+            return 0;
         }
+
+        /// <summary>
+        /// parameters of ransacFit()
+        /// </summary>
+        struct ransacParameters {
+            // number of random minimal samples that are tried
+            size_t iterations = 200;
+            // an equation is an inlier if |b_i - A_i * x| <= threshold
+            double threshold = 1;
+            // minimal number of inliers for a valid model, 0 -> number of unknowns
+            size_t minInliers = 0;
+            // seed of the random number generator
+            unsigned int seed = 42;
+            // number of threads the hypotheses are evaluated on
+            unsigned int threads = 1;
+        };
+
+        /// <summary>
+        /// parameters of irlsFit()
+        /// </summary>
+        struct irlsParameters {
+            // Huber tuning constant in units of the robust residual scale (1.345 -> 95% efficiency for normal errors)
+            double huberK = 1.345;
+            size_t maxIterations = 20;
+            // stop if the solution changes less than tolerance (relative)
+            double tolerance = 1e-8;
+        };
+
+        /// <summary>
+        /// RANSAC fit of b = A * x:
+        /// Solves many minimal systems (numberOfUnknowns randomly chosen equations), counts for each hypothesis
+        /// the equations that are fulfilled within the threshold and refits the best consensus set with
+        /// linFit(). Every thread works on its own preallocated workspace (only the QR solve of a hypothesis
+        /// uses a temporary of numberOfUnknowns values).
+        /// If "inliers" is given, it receives the inlier mask of the final model.
+        /// </summary>
+        /// <return>
+        /// Returns the number of inliers or -1 if no valid model was found.
+        /// </return>
+        template<typename T>
+        static int ransacFit(const vector<T>& b, const matrix<T>& A, vector<T>& x, const ransacParameters& parameters = ransacParameters(), std::vector<bool>* inliers = nullptr) {
+            const size_t n = A.rows();
+            const size_t k = A.cols();
+            if (n == 0 || k == 0 || b.size() != n || n < k)
+                return -1;
+
+            using eigen_matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+            using eigen_vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+            struct workspace {
+                workspace(size_t k) : A(k, k), b(k), x(k), qr(k, k), sample(k), best(k) {}
+                eigen_matrix A;
+                eigen_vector b, x;
+                Eigen::ColPivHouseholderQR<eigen_matrix> qr;
+                std::vector<size_t> sample;
+                eigen_vector best;
+                size_t bestCount = 0;
+            };
+
+            const unsigned int nthreads = std::max(1u, std::min<unsigned int>(parameters.threads, static_cast<unsigned int>(parameters.iterations)));
+            std::vector<workspace> workspaces(nthreads, workspace(k));
+            const T threshold = static_cast<T>(parameters.threshold);
+
+            utilities::parallelFor(0, parameters.iterations, nthreads, [&](size_t first, size_t last, unsigned int thread) {
+                workspace& ws = workspaces[thread];
+                std::mt19937 generator(parameters.seed + thread);
+                std::uniform_int_distribution<size_t> distribution(0, n - 1);
+                for (size_t iteration = first; iteration < last; ++iteration) {
+                    // draw k distinct equations
+                    for (size_t j = 0; j < k; ++j) {
+                        size_t candidate;
+                        do {
+                            candidate = distribution(generator);
+                        } while (std::find(ws.sample.begin(), ws.sample.begin() + j, candidate) != ws.sample.begin() + j);
+                        ws.sample[j] = candidate;
+                        ws.A.row(j) = A.eigen().row(candidate);
+                        ws.b(j) = b[candidate];
+                    }
+                    ws.qr.compute(ws.A);
+                    if (!ws.qr.isInvertible())
+                        continue;
+                    ws.x = ws.qr.solve(ws.b);
+
+                    // count the equations that are fulfilled by the hypothesis
+                    size_t count = 0;
+                    for (size_t i = 0; i < n; ++i)
+                        if (std::abs(b[i] - A.eigen().row(i).dot(ws.x)) <= threshold)
+                            ++count;
+                    if (count > ws.bestCount) {
+                        ws.bestCount = count;
+                        ws.best = ws.x;
+                    }
+                }
+            });
+
+            const workspace* best = &workspaces.front();
+            for (const workspace& ws : workspaces)
+                if (ws.bestCount > best->bestCount)
+                    best = &ws;
+            const size_t minInliers = std::max(parameters.minInliers, k);
+            if (best->bestCount < minInliers)
+                return -1;
+
+            // refit with all inliers of the best hypothesis (recounted, the residuals may differ in the last bits
+            // from the ones of the hypothesis pass)
+            std::vector<size_t> indices;
+            indices.reserve(best->bestCount);
+            for (size_t i = 0; i < n; ++i)
+                if (std::abs(b[i] - A.eigen().row(i).dot(best->best)) <= threshold)
+                    indices.push_back(i);
+            if (indices.size() < minInliers)
+                return -1;
+            matrix<T> Ain(indices.size(), k);
+            vector<T> bin(indices.size());
+            if (inliers)
+                inliers->assign(n, false);
+            for (size_t r = 0; r < indices.size(); ++r) {
+                Ain.eigen().row(r) = A.eigen().row(indices[r]);
+                bin[r] = b[indices[r]];
+                if (inliers)
+                    (*inliers)[indices[r]] = true;
+            }
+            if (linFit(bin, Ain, x) != 0)
+                return -1;
+            return static_cast<int>(indices.size());
+        }
+
+        /// <summary>
+        /// Robust fit of b = A * x with iteratively reweighted least squares and the Huber loss:
+        /// Equations with a residual |r_i| <= k * s get the weight 1, equations with larger residuals the weight
+        /// k * s / |r_i|, where s = median(|r|) / 0.6745 is a robust estimate of the residual scale.
+        /// The weighted systems are solved with a QR decomposition that is reused over the iterations.
+        /// </summary>
+        /// <return>
+        /// Returns the number of iterations or -1 if the fit failed.
+        /// </return>
+        template<typename T>
+        static int irlsFit(const vector<T>& b, const matrix<T>& A, vector<T>& x, const irlsParameters& parameters = irlsParameters()) {
+            const size_t n = A.rows();
+            const size_t k = A.cols();
+            if (n == 0 || k == 0 || b.size() != n)
+                return -1;
+
+            using eigen_matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+            using eigen_vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+            Eigen::ColPivHouseholderQR<eigen_matrix> qr(n, k);
+            eigen_matrix Aw(n, k);
+            eigen_vector bw(n), r(n), absr(n), sqrtw(n), xs(k), xnew(k);
+
+            qr.compute(A.eigen());
+            xs = qr.solve(b.eigen());
+            int iteration = 0;
+            for (; iteration < static_cast<int>(parameters.maxIterations); ++iteration) {
+                r.noalias() = b.eigen() - A.eigen() * xs;
+                absr = r.cwiseAbs();
+                std::nth_element(absr.data(), absr.data() + n / 2, absr.data() + n);
+                const T scale = absr(n / 2) / T(0.6745);
+                if (scale <= std::numeric_limits<T>::epsilon())
+                    break; // (almost) exact fit
+                const T limit = static_cast<T>(parameters.huberK) * scale;
+                for (size_t i = 0; i < n; ++i) {
+                    const T ri = std::abs(r(i));
+                    sqrtw(i) = ri <= limit ? T(1) : std::sqrt(limit / ri);
+                }
+                Aw.noalias() = sqrtw.asDiagonal() * A.eigen();
+                bw = sqrtw.cwiseProduct(b.eigen());
+                qr.compute(Aw);
+                xnew = qr.solve(bw);
+                const T change = (xnew - xs).norm();
+                xs.swap(xnew);
+                if (change <= static_cast<T>(parameters.tolerance) * std::max(T(1), xs.norm()))
+                    break;
+            }
+            x = vector<T>(xs);
+            return iteration;
+        }
+
+        /// <summary>
+        /// Maximal degree of the batched polynomial fits. Up to this degree the normal equations are solved
+        /// on the stack, higher degrees fall back to polyFit() with a QR decomposition.
+        /// </summary>
+        static constexpr size_t maxBatchDegree = 15;
+
+        /// <summary>
+        /// Fit a polynom of degree "degree" to many independent point sets in one call.
+        /// The point sets are stored one after another in "points" (one point (x, y) per row), set i consists
+        /// of the rows [offsets[i], offsets[i + 1]), i.e. offsets has numberOfSets + 1 entries.
+        /// Row i of "coefficients" receives the coefficients c0, c1, ..., cn of set i (the matrix is resized if needed).
+        /// Instead of building the Vandermonde matrix, the (degree + 1)^2 normal equations A^T A c = A^T b are
+        /// accumulated directly from the power sums of x and solved with a LDLT decomposition. This is much faster
+        /// for many small fits, but squares the condition number: keep the degree low and x of order one.
+        /// With numberOfThreads > 1 the sets are distributed over several threads.
+        /// </summary>
+        /// <return>
+        /// Returns the number of fits that failed (less than degree + 1 points or singular system),
+        /// the coefficients of failed fits are set to zero.
+        /// </return>
+        template<typename T>
+        static int polyFit(const matrix<T>& points, const std::vector<size_t>& offsets, size_t degree, matrix<T>& coefficients, unsigned int numberOfThreads = 1) {
+            const size_t numberOfSets = offsets.empty() ? 0 : offsets.size() - 1;
+            if (coefficients.rows() != numberOfSets || coefficients.cols() != degree + 1)
+                coefficients.resize(numberOfSets, degree + 1);
+
+            std::atomic<int> failed(0);
+            utilities::parallelFor(0, numberOfSets, numberOfThreads, [&](size_t first, size_t last, unsigned int) {
+                for (size_t set = first; set < last; ++set) {
+                    const size_t begin = offsets[set];
+                    const size_t n = offsets[set + 1] - begin;
+                    T* c = coefficients.data() + set * (degree + 1);
+                    if (polyFitNormal(points.data() + begin * points.cols(), n, points.cols(), degree, c) != 0)
+                        failed++;
+                }
+            });
+            return failed;
+        }
+
+        /// <summary>
+        /// Fit a polynom of degree "degree" to every point set in "pointSets", see above.
+        /// </summary>
+        template<typename T>
+        static int polyFit(const std::vector<matrix<T>>& pointSets, size_t degree, matrix<T>& coefficients, unsigned int numberOfThreads = 1) {
+            const size_t numberOfSets = pointSets.size();
+            if (coefficients.rows() != numberOfSets || coefficients.cols() != degree + 1)
+                coefficients.resize(numberOfSets, degree + 1);
+
+            std::atomic<int> failed(0);
+            utilities::parallelFor(0, numberOfSets, numberOfThreads, [&](size_t first, size_t last, unsigned int) {
+                for (size_t set = first; set < last; ++set) {
+                    const matrix<T>& points = pointSets[set];
+                    T* c = coefficients.data() + set * (degree + 1);
+                    if (polyFitNormal(points.data(), points.rows(), points.cols(), degree, c) != 0)
+                        failed++;
+                }
+            });
+            return failed;
+        }
+
+    private:
+        /// <summary>
+        /// solve the normal equations of a polynomial fit for n points (x, y), stored with a row stride of 'stride'.
+        /// The coefficients are written to c[0], ..., c[degree].
+        /// </summary>
+        template<typename T>
+        static int polyFitNormal(const T* points, size_t n, size_t stride, size_t degree, T* c) {
+            const size_t k = degree + 1;
+            std::fill(c, c + k, T(0));
+            if (n < k || stride < 2)
+                return -1;
+
+            if (degree > maxBatchDegree) {
+                matrix<T> set(n, 2);
+                for (size_t i = 0; i < n; ++i) {
+                    set(i, 0) = points[i * stride];
+                    set(i, 1) = points[i * stride + 1];
+                }
+                const vector<T> x = polyFit(set, degree);
+                if (x.size() != k)
+                    return -1;
+                std::copy(x.begin(), x.end(), c);
+                return 0;
+            }
+
+            // power sums s[m] = sum x^m (m = 0 ... 2 * degree) and t[j] = sum y * x^j (j = 0 ... degree)
+            T s[2 * maxBatchDegree + 1] = {};
+            T t[maxBatchDegree + 1] = {};
+            for (size_t i = 0; i < n; ++i) {
+                const T x = points[i * stride];
+                const T y = points[i * stride + 1];
+                T power = 1;
+                for (size_t m = 0; m < k; ++m) {
+                    s[m] += power;
+                    t[m] += y * power;
+                    power *= x;
+                }
+                for (size_t m = k; m < 2 * k - 1; ++m) {
+                    s[m] += power;
+                    power *= x;
+                }
+            }
+
+            // the normal matrix is a Hankel matrix: (A^T A)(i, j) = s[i + j]
+            using small_matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, 0, maxBatchDegree + 1, maxBatchDegree + 1>;
+            using small_vector = Eigen::Matrix<T, Eigen::Dynamic, 1, 0, maxBatchDegree + 1, 1>;
+            small_matrix N(k, k);
+            small_vector r(k);
+            for (size_t i = 0; i < k; ++i) {
+                for (size_t j = 0; j < k; ++j)
+                    N(i, j) = s[i + j];
+                r(i) = t[i];
+            }
+            const Eigen::LDLT<small_matrix> ldlt(N);
+            if (ldlt.info() != Eigen::Success || !ldlt.isPositive())
+                return -1;
+            // a rank deficient system (e.g. less than degree + 1 distinct x) has pivots of the order of rounding errors
+            const small_vector pivots = ldlt.vectorD().cwiseAbs();
+            if (pivots.minCoeff() <= static_cast<T>(k) * std::numeric_limits<T>::epsilon() * pivots.maxCoeff())
+                return -1;
+            Eigen::Map<small_vector>(c, k) = ldlt.solve(r);
+            return 0;
+        }
+    };
+
+    /// <summary>
+    /// Streaming least squares fit (recursive least squares).
+    /// The equations b_i = a_i * x are added one by one, every update costs O(k^2) where k is the number of unknowns,
+    /// independent of the number of equations seen so far.
+    /// Optionally older equations are down-weighted by an exponential forgetting factor lambda (0 < lambda <= 1),
+    /// or only the last 'window' equations are taken into account (sliding window, requires lambda = 1).
+    /// Example (trajectory tracking with a polynomial of degree 2):
+    /// math::utilities::recursiveFit<double> tracker(3, 1.0, 50);
+    /// tracker.addPoint(t, y); // every frame
+    /// const math::vector<double>& c = tracker.solution(); // c0 + c1 * t + c2 * t^2
+    /// </summary>
+    template<typename T>
+    class recursiveFit
+    {
+    public:
+        using eigen_matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+        using eigen_vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+        /// <summary>
+        /// numberOfUnknowns: number of unknowns k (degree + 1 for polynomial fits)
+        /// lambda:           exponential forgetting factor, 1 -> no forgetting
+        /// window:           number of equations in the sliding window, 0 -> unlimited
+        /// delta:            initial covariance P = delta * I, large values -> weak prior x = 0
+        /// </summary>
+        recursiveFit(size_t numberOfUnknowns, T lambda = 1, size_t window = 0, T delta = 1e6)
+            : m_k(numberOfUnknowns), m_lambda(lambda), m_window(lambda == 1 ? window : 0), m_delta(delta),
+              m_P(numberOfUnknowns, numberOfUnknowns), m_Pa(numberOfUnknowns), m_row(numberOfUnknowns),
+              m_x(numberOfUnknowns), m_history(m_window * (numberOfUnknowns + 1)) {
+            reset();
+        }
+
+        /// <summary>
+        /// forget all equations
+        /// </summary>
+        void reset() {
+            m_P.setIdentity();
+            m_P *= m_delta;
+            m_x.eigen().setZero();
+            m_samples = 0;
+            m_head = 0;
+        }
+
+        /// <summary>
+        /// add the equation b = a * x, a must have numberOfUnknowns() entries
+        /// </summary>
+        void addRow(const vector<T>& a, T b) {
+            addRow(a.data(), b);
+        }
+
+        /// <summary>
+        /// add the equation b = a * x, a must point to numberOfUnknowns() values
+        /// </summary>
+        void addRow(const T* a, T b) {
+            const Eigen::Map<const eigen_vector> row(a, m_k);
+            if (m_window > 0) {
+                T* slot = m_history.data() + m_head * (m_k + 1);
+                bool rebuild = false;
+                if (m_samples == m_window) {
+                    // the oldest equation leaves the window, if it cannot be removed numerically
+                    // the estimate is recomputed from the equations in the window
+                    rebuild = !downdate(Eigen::Map<const eigen_vector>(slot, m_k), slot[m_k]);
+                    --m_samples;
+                }
+                std::copy(a, a + m_k, slot);
+                slot[m_k] = b;
+                m_head = (m_head + 1) % m_window;
+                if (rebuild) {
+                    ++m_samples;
+                    recompute();
+                    return;
+                }
+            }
+            update(row, b);
+            ++m_samples;
+        }
+
+        /// <summary>
+        /// add a point (x, y) for a polynomial fit P(x) = c0 + c1 * x + c2 * x^2 + ...
+        /// </summary>
+        void addPoint(T x, T y) {
+            T power = 1;
+            for (size_t j = 0; j < m_k; ++j) {
+                m_row[j] = power;
+                power *= x;
+            }
+            addRow(m_row.data(), y);
+        }
+
+        /// <summary>
+        /// current solution x
+        /// </summary>
+        const vector<T>& solution() const {
+            return m_x;
+        }
+
+        /// <summary>
+        /// number of equations that contribute to the solution
+        /// </summary>
+        size_t samples() const {
+            return m_samples;
+        }
+
+        /// <summary>
+        /// number of unknowns
+        /// </summary>
+        size_t numberOfUnknowns() const {
+            return m_k;
+        }
+
+    private:
+        /// <summary>
+        /// RLS update with the equation b = a * x:
+        /// g = P a / (lambda + a^T P a), x = x + g (b - a^T x), P = (P - g a^T P) / lambda
+        /// </summary>
+        template<class _Row>
+        void update(const _Row& a, T b) {
+            m_Pa.noalias() = m_P * a;
+            const T denom = m_lambda + a.dot(m_Pa);
+            const T error = b - a.dot(m_x.eigen());
+            m_x.eigen() += m_Pa * (error / denom);
+            m_P.noalias() -= (m_Pa / denom) * m_Pa.transpose();
+            if (m_lambda != 1)
+                m_P /= m_lambda;
+        }
+
+        /// <summary>
+        /// remove the equation b = a * x again:
+        /// g = P a / (1 - a^T P a), x = x - g (b - a^T x), P = P + g a^T P
+        /// returns false (and leaves P and x unchanged) if the downdate would make P indefinite
+        /// </summary>
+        template<class _Row>
+        bool downdate(const _Row& a, T b) {
+            m_Pa.noalias() = m_P * a;
+            const T denom = 1 - a.dot(m_Pa);
+            if (denom <= std::numeric_limits<T>::epsilon())
+                return false;
+            const T error = b - a.dot(m_x.eigen());
+            m_x.eigen() -= m_Pa * (error / denom);
+            m_P.noalias() += (m_Pa / denom) * m_Pa.transpose();
+            return true;
+        }
+
+        /// <summary>
+        /// recompute P and x from the m_samples equations in the window (oldest first)
+        /// </summary>
+        void recompute() {
+            m_P.setIdentity();
+            m_P *= m_delta;
+            m_x.eigen().setZero();
+            const size_t first = (m_head + m_window - m_samples) % m_window;
+            for (size_t i = 0; i < m_samples; ++i) {
+                const T* slot = m_history.data() + ((first + i) % m_window) * (m_k + 1);
+                update(Eigen::Map<const eigen_vector>(slot, m_k), slot[m_k]);
+            }
+        }
+
+        size_t m_k;
+        T m_lambda;
+        size_t m_window;
+        T m_delta;
+        eigen_matrix m_P; // covariance (A^T A)^-1
+        eigen_vector m_Pa; // work vector P * a
+        vector<T> m_row; // work vector for the polynomial terms
+        vector<T> m_x; // solution
+        std::vector<T> m_history; // ring buffer of the equations in the window (a, b)
+        size_t m_samples = 0;
+        size_t m_head = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "jobs.h"
+#include "parallel.h"
+
+thread_local bool jobSystem::t_insideJob = false;
+
+namespace {
+    void runChunks(size_t numberOfChunks, void* context, void (*chunk)(void* context, size_t index)) {
+        jobSystem::instance().parallelFor(0, numberOfChunks, 1, [=](size_t begin, size_t end, unsigned int) {
+            for (size_t i = begin; i < end; ++i)
+                chunk(context, i);
+        });
+    }
+
+    // math::utilities::parallelFor uses the thread pool instead of new threads when the job system is linked in
+    const bool registered = (math::parallelization::runner = &runChunks, true);
+}
+
+jobSystem::jobSystem(unsigned int numberOfThreads)
+    : m_invoke(nullptr), m_context(nullptr), m_grainSize(1), m_generation(0), m_active(0), m_stop(false) {
+    if (numberOfThreads == 0) {
+        const unsigned int hw = std::thread::hardware_concurrency();
+        numberOfThreads = hw > 0 ? hw : 1;
+    }
+    m_slices = std::vector<slice>(numberOfThreads);
+    m_workers.reserve(numberOfThreads - 1);
+    for (unsigned int t = 1; t < numberOfThreads; ++t)
+        m_workers.emplace_back(&jobSystem::workerLoop, this, t);
+}
+
+jobSystem::~jobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+unsigned int jobSystem::numberOfThreads() const {
+    return static_cast<unsigned int>(m_slices.size());
+}
+
+jobSystem& jobSystem::instance() {
+    static jobSystem jobs;
+    return jobs;
+}
+
+void jobSystem::run(size_t first, size_t last, size_t grainSize, invokeFunction invoke, void* context) {
+    // one job at a time, concurrent callers wait
+    std::lock_guard<std::mutex> submit(m_submit);
+
+    // distribute the range evenly over the slices
+    const size_t n = last - first;
+    const size_t nthreads = m_slices.size();
+    size_t begin = first;
+    for (size_t t = 0; t < nthreads; ++t) {
+        const size_t end = begin + n / nthreads + (t < n % nthreads ? 1 : 0);
+        m_slices[t].next.store(begin, std::memory_order_relaxed);
+        m_slices[t].end = end;
+        begin = end;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_invoke = invoke;
+        m_context = context;
+        m_grainSize = grainSize;
+        m_active = static_cast<unsigned int>(m_workers.size());
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_active == 0; });
+}
+
+void jobSystem::work(unsigned int thread) {
+    t_insideJob = true;
+    const size_t nthreads = m_slices.size();
+    // own slice first, then steal from the others
+    for (size_t k = 0; k < nthreads; ++k) {
+        slice& s = m_slices[(thread + k) % nthreads];
+        for (;;) {
+            const size_t begin = s.next.fetch_add(m_grainSize, std::memory_order_relaxed);
+            if (begin >= s.end)
+                break;
+            m_invoke(m_context, begin, std::min(begin + m_grainSize, s.end), thread);
+        }
+    }
+    t_insideJob = false;
+}
+
+void jobSystem::workerLoop(unsigned int thread) {
+    size_t generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&]() { return m_stop || m_generation != generation; });
+            if (m_stop)
+                return;
+            generation = m_generation;
+        }
+        work(thread);
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            last = --m_active == 0;
+        }
+        if (last)
+            m_done.notify_one();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+/*
+ *  jobs.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+// A small work-stealing job system with a persistent pool of worker threads.
+// parallelFor splits a range into one slice per thread. Every thread processes its own slice in chunks of
+// grainSize and steals chunks from the slices of the other threads when its own slice is exhausted.
+// The calling thread takes part in the work. No memory is allocated after the construction.
+class jobSystem {
+public:
+    // numberOfThreads: total number of threads including the calling thread, 0 = std::thread::hardware_concurrency()
+    explicit jobSystem(unsigned int numberOfThreads = 0);
+    ~jobSystem();
+    jobSystem(const jobSystem&) = delete;
+    jobSystem& operator=(const jobSystem&) = delete;
+
+    // number of threads including the calling thread
+    unsigned int numberOfThreads() const;
+
+    // call func(begin, end, thread) for chunks of at most grainSize elements of the range [first, last), thread is in
+    // [0, numberOfThreads()). Blocks until the whole range is processed. Calls from inside a job and ranges that fit
+    // into one chunk are processed by the calling thread (thread = 0).
+    template<class F>
+    void parallelFor(size_t first, size_t last, size_t grainSize, F&& func) {
+        if (last <= first)
+            return;
+        grainSize = std::max<size_t>(grainSize, 1);
+        if (m_workers.empty() || t_insideJob || last - first <= grainSize) {
+            func(first, last, 0u);
+            return;
+        }
+        auto invoke = [](void* context, size_t begin, size_t end, unsigned int thread) {
+            (*static_cast<typename std::remove_reference<F>::type*>(context))(begin, end, thread);
+        };
+        run(first, last, grainSize, invoke, &func);
+    }
+
+    // the job system shared by the library (hardware_concurrency() threads, created on first use)
+    static jobSystem& instance();
+
+private:
+    using invokeFunction = void (*)(void* context, size_t begin, size_t end, unsigned int thread);
+
+    // slice of the range owned by one thread, aligned to avoid false sharing between the threads
+    struct alignas(64) slice {
+        std::atomic<size_t> next;
+        size_t end;
+    };
+
+    void run(size_t first, size_t last, size_t grainSize, invokeFunction invoke, void* context);
+    void work(unsigned int thread);
+    void workerLoop(unsigned int thread);
+
+    std::vector<std::thread> m_workers;
+    std::vector<slice> m_slices;
+
+    // the current job
+    invokeFunction m_invoke;
+    void* m_context;
+    size_t m_grainSize;
+
+    std::mutex m_submit;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    size_t m_generation;
+    unsigned int m_active;
+    bool m_stop;
+
+    static thread_local bool t_insideJob;
+};
\ No newline at end of file
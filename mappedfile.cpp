@@ -0,0 +1,72 @@
+#include "mappedfile.h"
+#include <cstdio>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPEDFILE_MMAP
+#endif
+
+mappedFile::mappedFile() : m_data(nullptr), m_size(0), m_mapped(false) {
+}
+
+mappedFile::~mappedFile() {
+    close();
+}
+
+bool mappedFile::open(const std::string& filename) {
+    close();
+#ifdef MAPPEDFILE_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = static_cast<const unsigned char*>(data);
+            m_size = static_cast<size_t>(st.st_size);
+            m_mapped = true;
+        }
+    }
+    ::close(fd);
+    if (m_mapped)
+        return true;
+#endif
+    FILE* file = std::fopen(filename.c_str(), "rb");
+    if (!file)
+        return false;
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    m_buffer.resize(size > 0 ? static_cast<size_t>(size) : 0);
+    const bool ok = m_buffer.empty() || std::fread(m_buffer.data(), 1, m_buffer.size(), file) == m_buffer.size();
+    std::fclose(file);
+    if (!ok) {
+        m_buffer.clear();
+        return false;
+    }
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+}
+
+void mappedFile::close() {
+#ifdef MAPPEDFILE_MMAP
+    if (m_mapped)
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_buffer.clear();
+}
+
+const unsigned char* mappedFile::data() const {
+    return m_data;
+}
+
+size_t mappedFile::size() const {
+    return m_size;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+/*
+ *  mappedfile.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A read only file in memory: memory mapped on systems with mmap, otherwise read into a buffer
+class mappedFile {
+public:
+    mappedFile();
+    ~mappedFile();
+    mappedFile(const mappedFile&) = delete;
+    mappedFile& operator=(const mappedFile&) = delete;
+
+    // returns false if the file cannot be read
+    bool open(const std::string& filename);
+    void close();
+
+    const unsigned char* data() const;
+    size_t size() const;
+
+private:
+    const unsigned char* m_data;
+    size_t m_size;
+    bool m_mapped;
+    std::vector<unsigned char> m_buffer;
+};
\ No newline at end of file
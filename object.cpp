@@ -1,11 +1,20 @@
 #include "object.h"
-#include <iostream>
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <algorithm>
+#include <cstring>
+#include "profiler.h"
+
+namespace {
+    thread_local object::error t_lastError = {nullptr, 0};
+    thread_local size_t t_errorCount = 0;
+}
 
 object::object(float x, float y, float vx, float vy, float hsize, float vsize, float angle, float spin, int mirrorX, int mirrorY) :
-    m_x(x), m_y(y), m_vx(vx), m_vy(vy), m_hsize(hsize), m_vsize(vsize), m_phi(angle), m_oldPhi(0.0), m_npoints(0),
-    m_spin(spin), m_mirrorX(mirrorX), m_mirrorY(mirrorY) {}
+    m_x(x), m_y(y), m_vx(vx), m_vy(vy), m_hsize(hsize), m_vsize(vsize), m_mass(1), m_phi(angle), m_oldPhi(0.0), m_npoints(0), m_ncollidable(0),
+    m_spin(spin), m_mirrorX(mirrorX), m_mirrorY(mirrorY) {
+    updateBounds();
+}
 
 float object::x() const {
     return m_x;
@@ -43,10 +52,22 @@ float object::phi() const {
     return m_phi;
 }
 
+float object::appliedAngle() const {
+    return m_oldPhi;
+}
+
 float object::spin() const {
     return m_spin;
 }
 
+int object::mirrorX() const {
+    return m_mirrorX;
+}
+
+int object::mirrorY() const {
+    return m_mirrorY;
+}
+
 float object::hsize() const {
     return m_hsize;
 }
@@ -55,10 +76,68 @@ float object::vsize() const {
     return m_vsize;
 }
 
+float object::mass() const {
+    return m_mass;
+}
+
+float object::invMass() const {
+    return m_mass > 0 ? 1 / m_mass : 0;
+}
+
 int object::npoints() const {
     return m_npoints;
 }
 
+float object::radius() const {
+    return m_radius;
+}
+
+float object::radiusSquare() const {
+    return m_radius2;
+}
+
+types::aabb<float> object::localAABB() const {
+    return m_aabb;
+}
+
+types::aabb<float> object::getAABB() const {
+    return {m_aabb.xmin + m_x, m_aabb.ymin + m_y, m_aabb.xmax + m_x, m_aabb.ymax + m_y};
+}
+
+void object::updateBounds() {
+    if (m_npoints == 0) {
+        m_radius = m_hsize / 2;
+        m_radius2 = m_radius * m_radius;
+        m_aabb = {-m_radius, -m_radius, m_radius, m_radius};
+        return;
+    }
+    m_radius2 = 0;
+    m_aabb = {0, 0, 0, 0};
+    bool first = true;
+    for (const types::point<float>& point : m_points) {
+        if (!point.iscollidable)
+            continue;
+        if (first) {
+            m_aabb = {point.x, point.y, point.x, point.y};
+            first = false;
+        }
+        extendBounds(point);
+    }
+    m_radius = std::sqrt(m_radius2);
+}
+
+void object::extendBounds(const types::point<float>& point) {
+    const float r2 = point.x * point.x + point.y * point.y;
+    if (r2 > m_radius2) {
+        m_radius2 = r2;
+        m_radius = std::sqrt(r2);
+    }
+    m_aabb.xmin = std::min(m_aabb.xmin, point.x);
+    m_aabb.ymin = std::min(m_aabb.ymin, point.y);
+    m_aabb.xmax = std::max(m_aabb.xmax, point.x);
+    m_aabb.ymax = std::max(m_aabb.ymax, point.y);
+}
+
 void object::setPos(float x, float y) {
     m_x = x;
     m_y = y;
@@ -72,6 +151,11 @@ void object::setv(float vx, float vy) {
 void object::setSize(float hsize, float vsize) {
     m_hsize = hsize;
     m_vsize = vsize;
+    updateBounds();
+}
+
+void object::setMass(float mass) {
+    m_mass = mass;
 }
 
 void object::setAngle(float angle) {
@@ -80,12 +164,26 @@ void object::setAngle(float angle) {
     // so we have to rotate only by the difference of the old and the
     // new angle
     float dphi = (m_phi - m_oldPhi); //angle in rad /360.0*(2*M_PI)
+    const float cosphi = std::cos(dphi);
+    const float sinphi = std::sin(dphi);
+    bool first = true;
     for (int i = 0; i < m_npoints; ++i) {
         // rotate all m_points
         float xfs = m_points[i].x;
         float yfs = m_points[i].y;
-        m_points[i].x = std::cos(dphi) * xfs - std::sin(dphi) * yfs;
-        m_points[i].y = std::sin(dphi) * xfs + std::cos(dphi) * yfs;
+        m_points[i].x = cosphi * xfs - sinphi * yfs;
+        m_points[i].y = sinphi * xfs + cosphi * yfs;
+        // the radius does not change by a rotation, but the bounding box does
+        if (m_points[i].iscollidable) {
+            if (first) {
+                m_aabb = {m_points[i].x, m_points[i].y, m_points[i].x, m_points[i].y};
+                first = false;
+            }
+            m_aabb.xmin = std::min(m_aabb.xmin, m_points[i].x);
+            m_aabb.ymin = std::min(m_aabb.ymin, m_points[i].y);
+            m_aabb.xmax = std::max(m_aabb.xmax, m_points[i].x);
+            m_aabb.ymax = std::max(m_aabb.ymax, m_points[i].y);
+        }
     }
     m_oldPhi = m_phi;
 }
@@ -109,6 +207,14 @@ void object::newPoint(float x, float y, int r, int g, int b, int a, bool iscol)
     m_points[m_npoints].a = a;
     m_points[m_npoints].iscollidable = iscol;
     m_npoints++;
+    if (iscol) {
+        if (m_ncollidable++ == 0)
+            updateBounds();
+        else
+            extendBounds(m_points[m_npoints - 1]);
+    } else if (m_npoints == 1) {
+        updateBounds();
+    }
 }
 
 types::xypoint<float> object::getPointXY(int n) const {
@@ -118,7 +224,7 @@ types::xypoint<float> object::getPointXY(int n) const {
         point.second = m_points[n].y + m_y;
         return point;
     }
-    std::cout << "an error occured in object.cpp: n = " << n << " is not a valid index" << std::endl;
+    reportError("object::getPointXY", n);
     return point;
 }
 
@@ -130,7 +236,7 @@ types::point<float> object::getPoint(int n) const {
         point.y = point.y + m_y;
         return point;
     }
-    std::cout << "an error occured in object::getPoint: n = " << n << " is not a valid index" << std::endl;
+    reportError("object::getPoint", n);
     return point;
 }
 
@@ -138,7 +244,7 @@ types::point<float> object::getPoint(int n) const {
 bool object::isCollidable(int n) const {
     if (n >= 0 && n < m_npoints)
         return m_points[n].iscollidable;
-    std::cout << "an error occured in object::isCollidable: n = " << n << " is not a valid index" << std::endl;
+    reportError("object::isCollidable", n);
     return true;
 }
 
@@ -146,15 +252,109 @@ void object::modifyPoint(float x, float y, int n) {
     if (n >= 0 && n < m_npoints) {
         m_points[n].x = m_hsize * x;
         m_points[n].y = m_vsize * y;
+        updateBounds();
         return;
     }
-    std::cout << "an error occured in object::modifyPoint: n = " << n << " is not a valid index" << std::endl;
+    reportError("object::modifyPoint", n);
     return;
 }
 
+void object::setPoints(const types::point<float>* points, int n) {
+    setPoints(points, n, m_phi);
+}
+
+void object::setPoints(const types::point<float>* points, int n, float appliedAngle) {
+    m_points.assign(points, points + std::max(n, 0));
+    m_npoints = static_cast<int>(m_points.size());
+    m_ncollidable = static_cast<int>(std::count_if(m_points.begin(), m_points.end(), [](const types::point<float>& p) { return p.iscollidable; }));
+    // the points are already rotated, the next setAngle only rotates by the difference
+    m_oldPhi = appliedAngle;
+    updateBounds();
+}
+
+void object::getPoints(types::point<float>* out) const {
+    const types::point<float>* points = m_points.data();
+    for (int i = 0; i < m_npoints; ++i) {
+        out[i] = points[i];
+        out[i].x += m_x;
+        out[i].y += m_y;
+    }
+}
+
+size_t object::stateSize() const {
+    return sizeof(state) + m_points.size() * sizeof(types::point<float>);
+}
+
+size_t object::stateSize(const unsigned char* in) {
+    state s;
+    std::memcpy(&s, in, sizeof(s));
+    return sizeof(state) + static_cast<size_t>(s.npoints) * sizeof(types::point<float>);
+}
+
+void object::saveState(unsigned char* out) const {
+    const state s = {m_x, m_y, m_vx, m_vy, m_hsize, m_vsize, m_mass, m_phi, m_oldPhi, m_spin,
+                     m_mirrorX, m_mirrorY, m_radius, m_radius2, m_aabb, m_npoints, m_ncollidable};
+    std::memcpy(out, &s, sizeof(s));
+    if (!m_points.empty())
+        std::memcpy(out + sizeof(s), m_points.data(), m_points.size() * sizeof(types::point<float>));
+}
+
+void object::restoreState(const unsigned char* in) {
+    state s;
+    std::memcpy(&s, in, sizeof(s));
+    m_x = s.x;
+    m_y = s.y;
+    m_vx = s.vx;
+    m_vy = s.vy;
+    m_hsize = s.hsize;
+    m_vsize = s.vsize;
+    m_mass = s.mass;
+    m_phi = s.phi;
+    m_oldPhi = s.oldPhi;
+    m_spin = s.spin;
+    m_mirrorX = s.mirrorX;
+    m_mirrorY = s.mirrorY;
+    m_radius = s.radius;
+    m_radius2 = s.radius2;
+    m_aabb = s.aabb;
+    m_npoints = s.npoints;
+    m_ncollidable = s.ncollidable;
+    // no allocation as long as the number of points did not grow
+    m_points.resize(static_cast<size_t>(s.npoints));
+    if (s.npoints > 0)
+        std::memcpy(m_points.data(), in + sizeof(s), m_points.size() * sizeof(types::point<float>));
+}
+
+object::error object::lastError() {
+    return t_lastError;
+}
+
+size_t object::errorCount() {
+    return t_errorCount;
+}
+
+void object::clearErrors() {
+    t_lastError = {nullptr, 0};
+    t_errorCount = 0;
+}
+
+void object::reportError(const char* function, int n) {
+    t_lastError = {function, n};
+    t_errorCount++;
+}
+
 void object::updatePosition(float dt) {
+    PROFILE_SCOPE("object::updatePosition");
     m_x = m_x + m_vx * dt;
     m_y = m_y + m_vy * dt;
     m_phi = m_phi + m_spin * dt;
     setAngle(m_phi);
+}
+
+void object::updatePositions(const std::vector<object*>& objects, float dt, jobSystem& jobs) {
+    // setAngle transforms all points of an object, so chunks of a few objects are already worth a job
+    jobs.parallelFor(0, objects.size(), 16, [&objects, dt](size_t begin, size_t end, unsigned int) {
+        for (size_t i = begin; i < end; ++i)
+            objects[i]->updatePosition(dt);
+    });
 }
\ No newline at end of file
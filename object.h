@@ -7,6 +7,7 @@
 #include <tuple>
 #include <vector>
 #include "point.h"
+#include "jobs.h"
 
 // TODO: add color to each point
 
@@ -29,15 +30,35 @@ public:
 
     // get the angle in respect to the y-axis
     float phi() const;
+    // angle by which the points are rotated at the moment (phi() is applied by the next setAngle or updatePosition)
+    float appliedAngle() const;
     float spin() const;
 
+    // mirror factors of the points (1: not mirrored, -1: mirrored)
+    int mirrorX() const;
+    int mirrorY() const;
+
     // gives the horizontal size
     float hsize() const;
     // gives the verticla size
     float vsize() const;
 
+    // mass of the object, 0 -> static object (infinite mass)
+    float mass() const;
+    float invMass() const;
+
     // get the number of points
     int npoints() const;
+
+    // largest distance of a collidable point from the center (hsize / 2 for objects without points)
+    // and its square, both are cached and updated whenever the points change
+    float radius() const;
+    float radiusSquare() const;
+
+    // bounding box of the collidable points in object coordinates (relative to the center)
+    // and in world coordinates
+    types::aabb<float> localAABB() const;
+    types::aabb<float> getAABB() const;
     
     // set the x and y position in the 2 dimensional world
     void setPos(float x, float y);
@@ -46,12 +67,18 @@ public:
     // set the size of the Object
     void setSize(float hsize, float vsize);
 
+    // set the mass of the object, 0 -> static object (infinite mass)
+    void setMass(float mass);
+
     // set the objects angle
     void setAngle(float angle);
     void setSpin(float spin);
     
     // update the new position of the Object
     void updatePosition(float dt);
+
+    // update the positions of many objects in parallel (see jobSystem::parallelFor)
+    static void updatePositions(const std::vector<object*>& objects, float dt, jobSystem& jobs = jobSystem::instance());
     
     // save a new coordinate and remember the index. iscol is used to determine
     // if point should be used for collision control
@@ -62,6 +89,38 @@ public:
     bool isCollidable(int n) const;
     void modifyPoint(float x, float y, int n);
 
+    // fast accessors for the inner loops (collision, rendering), the index is only checked in debug builds
+    types::point<float> getPointUnchecked(int n) const;
+    types::xypoint<float> getPointXYUnchecked(int n) const;
+    bool isCollidableUnchecked(int n) const;
+
+    // all npoints() points in object coordinates (relative to the center, see getCenterXY)
+    const types::point<float>* localPoints() const;
+    // replace all points by n points in object coordinates (already scaled, mirrored and rotated by phi(), like localPoints())
+    void setPoints(const types::point<float>* points, int n);
+    // the same for points that are rotated by appliedAngle, the rest of phi() is applied by the next setAngle or updatePosition
+    void setPoints(const types::point<float>* points, int n, float appliedAngle);
+    // copy all npoints() points in world coordinates to out
+    void getPoints(types::point<float>* out) const;
+
+    // serialization of the complete state (position, velocity, angles, size, mass, points and cached bounds),
+    // e.g. for snapshots. saveState writes stateSize() bytes, restoreState reads them again.
+    size_t stateSize() const;
+    void saveState(unsigned char* out) const;
+    void restoreState(const unsigned char* in);
+    // size of a saved state
+    static size_t stateSize(const unsigned char* in);
+
+    // error channel: invalid indices passed to the accessors are not printed, but counted per thread.
+    // lastError() gives the accessor and the index of the last error.
+    struct error {
+        const char* function;
+        int index;
+    };
+    static error lastError();
+    static size_t errorCount();
+    static void clearErrors();
+
 private:
     float m_x;
     float m_y;
@@ -69,12 +128,74 @@ private:
     float m_vy;
     float m_hsize;
     float m_vsize;
+    float m_mass;
     float m_phi; // angle in degree (°)
     float m_oldPhi; 
     // whenever save_point() is called, we increment this numbers
     int m_npoints;
+    int m_ncollidable;
     float m_spin;
     int m_mirrorX;
     int m_mirrorY;
     std::vector<types::point<float>> m_points; // points are defined in the object coordinate system
-};
\ No newline at end of file
+    // cached bounds of the collidable points
+    float m_radius;
+    float m_radius2;
+    types::aabb<float> m_aabb;
+
+    // recalculate the cached bounds from all points
+    void updateBounds();
+    // extend the cached bounds by one point
+    void extendBounds(const types::point<float>& point);
+
+    // report an invalid index to the error channel
+    static void reportError(const char* function, int n);
+
+    // the fixed size part of a saved state, followed by the points
+    struct state {
+        float x, y, vx, vy;
+        float hsize, vsize, mass;
+        float phi, oldPhi, spin;
+        int mirrorX, mirrorY;
+        float radius, radius2;
+        types::aabb<float> aabb;
+        int npoints, ncollidable;
+    };
+};
+
+inline types::point<float> object::getPointUnchecked(int n) const {
+#ifndef NDEBUG
+    if (n < 0 || n >= m_npoints) {
+        reportError("object::getPointUnchecked", n);
+        return types::point<float>();
+    }
+#endif
+    types::point<float> point = m_points[n];
+    point.x += m_x;
+    point.y += m_y;
+    return point;
+}
+
+inline types::xypoint<float> object::getPointXYUnchecked(int n) const {
+#ifndef NDEBUG
+    if (n < 0 || n >= m_npoints) {
+        reportError("object::getPointXYUnchecked", n);
+        return types::xypoint<float>();
+    }
+#endif
+    return {m_points[n].x + m_x, m_points[n].y + m_y};
+}
+
+inline bool object::isCollidableUnchecked(int n) const {
+#ifndef NDEBUG
+    if (n < 0 || n >= m_npoints) {
+        reportError("object::isCollidableUnchecked", n);
+        return true;
+    }
+#endif
+    return m_points[n].iscollidable;
+}
+
+inline const types::point<float>* object::localPoints() const {
+    return m_points.data();
+}
\ No newline at end of file
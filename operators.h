@@ -7,7 +7,11 @@
 #pragma once
 #include "vector.h"
 #include "matrix.h"
+#include "parallel.h"
 #include <iostream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace math {
     /// <summary>
@@ -222,68 +226,104 @@ namespace math {
         return matrix<_T>(mat.eigen() / scalar);
     }
 
+    namespace eigen {
+        /// <summary>
+        /// matrix-vector multiplication sol = mat * vec, split up into blocks of parallelization::blockRows rows.
+        /// The matrix is stored row-major, therefore every block is a contiguous piece of memory.
+        /// </summary>
+        template <class _T>
+        inline void parallelProduct(const matrix<_T>& mat, const vector<_T>& vec, vector<_T>& sol) {
+            const std::size_t blockRows = std::max<std::size_t>(1, parallelization::blockRows);
+            const std::size_t nblocks = (mat.rows() + blockRows - 1) / blockRows;
+            auto multiplyBlocks = [&](std::size_t first, std::size_t last) {
+                for (std::size_t block = first; block < last; ++block) {
+                    const std::size_t r = block * blockRows;
+                    const std::size_t n = std::min(blockRows, mat.rows() - r);
+                    sol.eigen().segment(r, n).noalias() = mat.eigen().middleRows(r, n) * vec.eigen();
+                }
+            };
+
+#ifdef _OPENMP
+            if (parallelization::mode == multiplication::openmp) {
+                const long long numberOfBlocks = static_cast<long long>(nblocks);
+#pragma omp parallel for schedule(static) num_threads(parallelization::numberOfThreads())
+                for (long long block = 0; block < numberOfBlocks; ++block)
+                    multiplyBlocks(static_cast<std::size_t>(block), static_cast<std::size_t>(block) + 1);
+                return;
+            }
+#endif
+            utilities::parallelFor(0, nblocks, parallelization::numberOfThreads(),
+                [&](std::size_t first, std::size_t last, unsigned int) { multiplyBlocks(first, last); });
+        }
+
+        /// <summary>
+        /// vector-matrix multiplication sol = vecT^T * mat, split up into blocks of parallelization::blockRows rows.
+        /// Every thread accumulates the product of its rows in a partial sum, the partial sums are added up at the end.
+        /// </summary>
+        template <class _T>
+        inline void parallelProduct(const vector<_T>& vecT, const matrix<_T>& mat, vector<_T>& sol) {
+            using row_type = Eigen::Matrix<_T, 1, Eigen::Dynamic>;
+            const std::size_t blockRows = std::max<std::size_t>(1, parallelization::blockRows);
+            const std::size_t nblocks = (mat.rows() + blockRows - 1) / blockRows;
+            const unsigned int nthreads = static_cast<unsigned int>(std::min<std::size_t>(parallelization::numberOfThreads(), nblocks));
+            std::vector<row_type> partial(nthreads, row_type::Zero(mat.cols()));
+            auto multiplyBlocks = [&](std::size_t first, std::size_t last, row_type& acc) {
+                for (std::size_t block = first; block < last; ++block) {
+                    const std::size_t r = block * blockRows;
+                    const std::size_t n = std::min(blockRows, mat.rows() - r);
+                    acc.noalias() += vecT.eigen().segment(r, n).transpose() * mat.eigen().middleRows(r, n);
+                }
+            };
+
+#ifdef _OPENMP
+            if (parallelization::mode == multiplication::openmp) {
+                const long long numberOfBlocks = static_cast<long long>(nblocks);
+#pragma omp parallel num_threads(nthreads)
+                {
+                    row_type& acc = partial[omp_get_thread_num()];
+#pragma omp for schedule(static)
+                    for (long long block = 0; block < numberOfBlocks; ++block)
+                        multiplyBlocks(static_cast<std::size_t>(block), static_cast<std::size_t>(block) + 1, acc);
+                }
+            } else
+#endif
+            utilities::parallelFor(0, nblocks, nthreads,
+                [&](std::size_t first, std::size_t last, unsigned int thread) { multiplyBlocks(first, last, partial[thread]); });
+
+            sol.eigen().setZero();
+            for (const row_type& acc : partial)
+                sol.eigen() += acc.transpose();
+        }
+    }
+
     /// <summary>
     /// matrix-vector multiplication
+    /// Large products (see parallelization::threshold) are split up into row blocks and evaluated
+    /// in parallel if parallelization::mode is set to threads or openmp.
     /// </summary>
     template <class _T>
     inline vector<_T> operator*(const matrix<_T>& mat, const vector<_T>& vec) {
-#define EIGENMULT
-//#define PARALLELIZATION
-#ifdef EIGENMULT
-        return vector<_T>(mat.eigen() * vec.eigen());
-#else
-#ifdef PARALLELIZATION
-        int r;
-        vector<_T> sol(mat.rows());
-#pragma omp parallel default(none) private(r) shared(vec, mat, sol)
-        {
-#pragma omp for schedule(static, 16)
-            for (r = 0; r < mat.rows(); ++r)
-                sol[r] = mat[r].eigen().transpose() * vec.eigen();
-        }
-        return sol;
-#else
-        // probably a bit faster.
+        if (!parallelization::enabled(mat.rows(), mat.cols()))
+            return vector<_T>(mat.eigen() * vec.eigen());
+
         vector<_T> sol(mat.rows());
-        for (size_t r = 0; r < mat.rows(); ++r)
-            sol[r] = mat[r].eigen().transpose() * vec.eigen();
+        eigen::parallelProduct(mat, vec, sol);
         return sol;
-#endif
-#undef PARALLELIZATION
-#endif
-#undef EIGENMULT
     }
 
     /// <summary>
-    /// matrix-vector multiplication
+    /// vector-matrix multiplication
+    /// Large products (see parallelization::threshold) are split up into row blocks and evaluated
+    /// in parallel if parallelization::mode is set to threads or openmp.
     /// </summary>
     template <class _T>
     inline vector<_T> operator*(const vector<_T>& vecT, const matrix<_T>& mat) {
-#define EIGENMULT
-//#define PARALLELIZATION
-#ifdef EIGENMULT
-        // probably a bit faster
-        return vector<_T>(vecT.eigen().transpose() * mat.eigen());
-#else
-#ifndef PARALLELIZATION
-        int r;
-        vector<_T> sol(mat.cols());
-#pragma omp parallel default(none) private(r) shared(vecT, mat, sol)
-        {
-#pragma omp for schedule(static, 16)
-            for (r = 0; r < mat.cols(); ++r)
-                sol[r] = mat.eigen().transpose().row(r) * vecT.eigen();
-        }
-        return sol;
-#else
+        if (!parallelization::enabled(mat.rows(), mat.cols()))
+            return vector<_T>(vecT.eigen().transpose() * mat.eigen());
+
         vector<_T> sol(mat.cols());
-        for (size_t r = 0; r < mat.cols(); ++r)
-            sol[r] = mat.eigen().transpose().row(r) * vecT.eigen();
+        eigen::parallelProduct(vecT, mat, sol);
         return sol;
-#endif
-#undef PARALLELIZATION
-#endif
-#undef EIGENMULT
     }
 
     /// <summary>
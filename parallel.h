@@ -0,0 +1,109 @@
+/*
+ *  parallel.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+namespace math {
+    /// <summary>
+    /// how the matrix-vector products in operators.h are evaluated
+    /// eigen:   single threaded Eigen product (default)
+    /// threads: row blocks distributed over std::thread's
+    /// openmp:  row blocks distributed by an OpenMP parallel for (falls back to threads if compiled without -fopenmp)
+    /// </summary>
+    enum class multiplication {
+        eigen,
+        threads,
+        openmp
+    };
+
+    /// <summary>
+    /// runtime configuration of the parallel matrix-vector products
+    /// Define PARALLELIZATION to make the threaded (or OpenMP, if available) product the default.
+    /// </summary>
+    struct parallelization {
+#ifdef PARALLELIZATION
+#ifdef _OPENMP
+        static inline multiplication mode = multiplication::openmp;
+#else
+        static inline multiplication mode = multiplication::threads;
+#endif
+#else
+        static inline multiplication mode = multiplication::eigen;
+#endif
+        // minimal number of matrix entries (rows * cols) before the product is split up,
+        // smaller products are always evaluated by Eigen
+        static inline std::size_t threshold = 1 << 16;
+        // number of rows that are multiplied in one go by one thread
+        static inline std::size_t blockRows = 256;
+        // number of threads, 0: std::thread::hardware_concurrency()
+        static inline unsigned int threads = 0;
+
+        // runs chunk(context, i) for all i in [0, numberOfChunks) in parallel and returns when all chunks are done.
+        // Set by jobs.cpp if it is linked in (utilities::parallelFor then uses the threads of jobSystem::instance()),
+        // nullptr: utilities::parallelFor starts its own threads, so the math headers do not depend on jobs.cpp.
+        using chunkRunner = void (*)(std::size_t numberOfChunks, void* context, void (*chunk)(void* context, std::size_t index));
+        static inline chunkRunner runner = nullptr;
+
+        /// <summary>
+        /// number of threads that are actually used
+        /// </summary>
+        static unsigned int numberOfThreads() {
+            if (threads > 0)
+                return threads;
+            const unsigned int hw = std::thread::hardware_concurrency();
+            return hw > 0 ? hw : 1;
+        }
+
+        /// <summary>
+        /// true if a product of a matrix with size rows x cols should be split up
+        /// </summary>
+        static bool enabled(std::size_t rows, std::size_t cols) {
+            return mode != multiplication::eigen && rows * cols >= threshold && rows > blockRows;
+        }
+    };
+
+    namespace utilities {
+        /// <summary>
+        /// call func(begin, end, thread) for 'numberOfThreads' contiguous chunks of the range [first, last),
+        /// thread is the index of the chunk (every index is used exactly once, e.g. for per-thread workspaces).
+        /// The chunks are processed by parallelization::runner if it is set, otherwise by new threads and the calling thread.
+        /// </summary>
+        template <class _Func>
+        void parallelFor(std::size_t first, std::size_t last, unsigned int numberOfThreads, _Func&& func) {
+            if (last <= first)
+                return;
+            const std::size_t n = last - first;
+            const std::size_t nthreads = std::max<std::size_t>(1, std::min<std::size_t>(numberOfThreads, n));
+            if (nthreads == 1) {
+                func(first, last, 0u);
+                return;
+            }
+
+            const std::size_t chunk = n / nthreads;
+            const std::size_t remainder = n % nthreads;
+            auto run = [&](std::size_t t) {
+                const std::size_t begin = first + t * chunk + std::min(t, remainder);
+                const std::size_t end = begin + chunk + (t < remainder ? 1 : 0);
+                func(begin, end, static_cast<unsigned int>(t));
+            };
+            if (parallelization::runner) {
+                auto invoke = [](void* context, std::size_t t) { (*static_cast<decltype(run)*>(context))(t); };
+                parallelization::runner(nthreads, &run, invoke);
+                return;
+            }
+            std::vector<std::thread> workers;
+            workers.reserve(nthreads - 1);
+            for (std::size_t t = 0; t + 1 < nthreads; ++t)
+                workers.emplace_back([&run, t]() { run(t); });
+            run(nthreads - 1);
+            for (std::thread& worker : workers)
+                worker.join();
+        }
+    }
+}
\ No newline at end of file
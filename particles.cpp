@@ -0,0 +1,178 @@
+#include "particles.h"
+#include <cmath>
+#include <algorithm>
+#include "algorithms.h"
+#include "profiler.h"
+
+namespace {
+    // Runge-Kutta 4. order step of x'' = ww * x + bet * x' + al (like rungeKuttaSolver::step, but inlined so that
+    // the particle loop can be vectorized)
+    inline void rungeKutta(float ww, float bet, float al, float dt, float& x, float& v) {
+        const float a1 = ww * x + bet * v + al;
+        const float v2 = v + 0.5f * a1 * dt;
+        const float a2 = ww * (x + 0.5f * v * dt) + bet * v2 + al;
+        const float v3 = v + 0.5f * a2 * dt;
+        const float a3 = ww * (x + 0.5f * v2 * dt) + bet * v3 + al;
+        const float v4 = v + a3 * dt;
+        const float a4 = ww * (x + v3 * dt) + bet * v4 + al;
+        x += dt * (1.0f / 6 * v + 1.0f / 3 * v2 + 1.0f / 3 * v3 + 1.0f / 6 * v4);
+        v += dt * (1.0f / 6 * a1 + 1.0f / 3 * a2 + 1.0f / 3 * a3 + 1.0f / 6 * a4);
+    }
+}
+
+particleSystem::particleSystem(size_t capacity, unsigned int seed)
+    : m_size(0), m_x(capacity), m_y(capacity), m_vx(capacity), m_vy(capacity), m_age(capacity), m_lifetime(capacity),
+      m_emitter(capacity), m_random(seed) {
+}
+
+int particleSystem::addEmitter(const emitter& e) {
+    m_emitters.push_back(e);
+    return static_cast<int>(m_emitters.size()) - 1;
+}
+
+particleSystem::emitter& particleSystem::getEmitter(int id) {
+    return m_emitters[id];
+}
+
+size_t particleSystem::numberOfEmitters() const {
+    return m_emitters.size();
+}
+
+size_t particleSystem::burst(int id, size_t n) {
+    n = std::min(n, capacity() - m_size);
+    spawn(id, n);
+    return n;
+}
+
+particleSystem::forces& particleSystem::getForces() {
+    return m_forces;
+}
+
+void particleSystem::setForces(const forces& f) {
+    m_forces = f;
+}
+
+void particleSystem::spawn(int id, size_t n) {
+    const emitter& e = m_emitters[id];
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    for (size_t k = 0; k < n; ++k) {
+        const size_t i = m_size++;
+        const float angle = e.direction + 0.5f * e.spread * uniform(m_random);
+        const float speed = e.speed + e.speedVariation * uniform(m_random);
+        m_x[i] = e.x;
+        m_y[i] = e.y;
+        m_vx[i] = speed * std::cos(angle);
+        m_vy[i] = speed * std::sin(angle);
+        m_age[i] = 0;
+        m_lifetime[i] = std::max(e.lifetime + e.lifetimeVariation * uniform(m_random), 1e-3f);
+        m_emitter[i] = static_cast<uint32_t>(id);
+    }
+}
+
+void particleSystem::remove(size_t i) {
+    const size_t last = --m_size;
+    m_x[i] = m_x[last];
+    m_y[i] = m_y[last];
+    m_vx[i] = m_vx[last];
+    m_vy[i] = m_vy[last];
+    m_age[i] = m_age[last];
+    m_lifetime[i] = m_lifetime[last];
+    m_emitter[i] = m_emitter[last];
+}
+
+void particleSystem::update(float dt, jobSystem& jobs) {
+    PROFILE_SCOPE("particleSystem::update");
+    // emission
+    for (size_t id = 0; id < m_emitters.size(); ++id) {
+        emitter& e = m_emitters[id];
+        if (!e.active || e.rate <= 0)
+            continue;
+        e.accumulator += e.rate * dt;
+        const size_t n = static_cast<size_t>(e.accumulator);
+        e.accumulator -= n;
+        spawn(static_cast<int>(id), std::min(n, capacity() - m_size));
+    }
+
+    // integration, relative to the anchor so that the spring term is ww * x
+    const forces f = m_forces;
+    float* x = m_x.data();
+    float* y = m_y.data();
+    float* vx = m_vx.data();
+    float* vy = m_vy.data();
+    float* age = m_age.data();
+    jobs.parallelFor(0, m_size, 4096, [=](size_t begin, size_t end, unsigned int) {
+        ALGORITHMS_PRAGMA(omp simd)
+        for (size_t i = begin; i < end; ++i) {
+            float px = x[i] - f.anchorX;
+            float py = y[i] - f.anchorY;
+            rungeKutta(f.ww, f.bet, f.alx, dt, px, vx[i]);
+            rungeKutta(f.ww, f.bet, f.aly, dt, py, vy[i]);
+            x[i] = px + f.anchorX;
+            y[i] = py + f.anchorY;
+            age[i] += dt;
+        }
+    });
+
+    // remove the dead particles, the replacement from the end is checked again
+    for (size_t i = 0; i < m_size;) {
+        if (m_age[i] >= m_lifetime[i])
+            remove(i);
+        else
+            ++i;
+    }
+    PROFILE_COUNT("particles simulated", m_size);
+}
+
+void particleSystem::clear() {
+    m_size = 0;
+}
+
+size_t particleSystem::size() const {
+    return m_size;
+}
+
+size_t particleSystem::capacity() const {
+    return m_x.size();
+}
+
+const float* particleSystem::x() const {
+    return m_x.data();
+}
+
+const float* particleSystem::y() const {
+    return m_y.data();
+}
+
+const float* particleSystem::vx() const {
+    return m_vx.data();
+}
+
+const float* particleSystem::vy() const {
+    return m_vy.data();
+}
+
+const float* particleSystem::age() const {
+    return m_age.data();
+}
+
+const float* particleSystem::lifetime() const {
+    return m_lifetime.data();
+}
+
+particleSystem::color particleSystem::getColor(size_t i) const {
+    const emitter& e = m_emitters[m_emitter[i]];
+    const float t = algorithms::constrain(m_age[i] / m_lifetime[i], 0.0f, 1.0f);
+    return {static_cast<int>(e.startColor.r + t * (e.endColor.r - e.startColor.r)),
+            static_cast<int>(e.startColor.g + t * (e.endColor.g - e.startColor.g)),
+            static_cast<int>(e.startColor.b + t * (e.endColor.b - e.startColor.b)),
+            static_cast<int>(e.startColor.a + t * (e.endColor.a - e.startColor.a))};
+}
+
+void particleSystem::addTo(frameGeometry& frame) const {
+    const size_t first = frame.particles.size();
+    frame.particles.resize(first + m_size);
+    for (size_t i = 0; i < m_size; ++i) {
+        const color c = getColor(i);
+        frame.particles[first + i] = {m_x[i], m_y[i], m_emitters[m_emitter[i]].size, c.r, c.g, c.b, c.a};
+    }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+/*
+ *  particles.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <random>
+#include "backend.h"
+#include "jobs.h"
+
+// Particle effects (explosions, thrusters, sparks) without one object per particle.
+// The particles are stored as structure of arrays with a fixed capacity, dead particles are replaced by the last one.
+// Both axes are integrated like a solver: x'' = ww * (x - anchor) + bet * x' + al (Runge-Kutta 4. order), i.e.
+// ww < 0 pulls the particles back to the anchor with a spring, bet < 0 damps them and al is a constant acceleration.
+class particleSystem {
+public:
+    struct color {
+        int r, g, b, a;
+    };
+
+    struct emitter {
+        // position of the emitter in screen coordinates
+        float x = 0, y = 0;
+        // particles per second, 0: particles are only emitted by burst
+        float rate = 0;
+        // direction and opening angle of the emission (radians)
+        float direction = 0;
+        float spread = 6.2831853f;
+        // initial speed in pixels per second, uniformly distributed in speed +- speedVariation
+        float speed = 100;
+        float speedVariation = 0;
+        // lifetime in seconds, uniformly distributed in lifetime +- lifetimeVariation
+        float lifetime = 1;
+        float lifetimeVariation = 0;
+        // radius of the particles in pixels
+        float size = 1;
+        // color at the beginning and at the end of the lifetime (linearly interpolated, also for living particles
+        // if the emitter is changed)
+        color startColor = {255, 255, 255, 255};
+        color endColor = {255, 255, 255, 0};
+        bool active = true;
+        // fraction of a particle that is carried over to the next update
+        float accumulator = 0;
+    };
+
+    // coefficients of the equation of motion, shared by all particles
+    struct forces {
+        float ww = 0;
+        float bet = 0;
+        float alx = 0, aly = 0;
+        float anchorX = 0, anchorY = 0;
+    };
+
+    explicit particleSystem(size_t capacity, unsigned int seed = 5489u);
+
+    // add an emitter, returns its id
+    int addEmitter(const emitter& e);
+    emitter& getEmitter(int id);
+    size_t numberOfEmitters() const;
+
+    // emit n particles at once (e.g. an explosion), returns the number of emitted particles (limited by the capacity)
+    size_t burst(int id, size_t n);
+
+    forces& getForces();
+    void setForces(const forces& f);
+
+    // emit the particles of the active emitters, integrate all particles by dt and remove the dead ones
+    void update(float dt, jobSystem& jobs = jobSystem::instance());
+
+    // remove all particles
+    void clear();
+
+    // number of living particles
+    size_t size() const;
+    size_t capacity() const;
+
+    // state of the living particles [0, size())
+    const float* x() const;
+    const float* y() const;
+    const float* vx() const;
+    const float* vy() const;
+    const float* age() const;
+    const float* lifetime() const;
+
+    // color of particle i according to its age
+    color getColor(size_t i) const;
+
+    // append all particles to the geometry of a frame (drawn by every backend)
+    void addTo(frameGeometry& frame) const;
+
+private:
+    void spawn(int id, size_t n);
+    void remove(size_t i);
+
+    size_t m_size;
+    std::vector<float> m_x, m_y, m_vx, m_vy;
+    std::vector<float> m_age, m_lifetime;
+    std::vector<uint32_t> m_emitter;
+
+    std::vector<emitter> m_emitters;
+    forces m_forces;
+    std::mt19937 m_random;
+};
\ No newline at end of file
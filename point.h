@@ -24,4 +24,10 @@ namespace types {
         // should be collision detection applied
         bool iscollidable;
     };
+
+    // axis aligned bounding box
+    template<typename T>
+    struct aabb {
+        T xmin, ymin, xmax, ymax;
+    };
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "polyline.h"
+#include <utility>
+
+namespace {
+    // squared distance of point p from the segment a -> b
+    float segmentDistanceSquare(const types::xypoint<float>& p, const types::xypoint<float>& a, const types::xypoint<float>& b) {
+        const float abx = b.first - a.first;
+        const float aby = b.second - a.second;
+        const float apx = p.first - a.first;
+        const float apy = p.second - a.second;
+        const float len2 = abx * abx + aby * aby;
+        float t = len2 > 0 ? (apx * abx + apy * aby) / len2 : 0;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        const float dx = apx - t * abx;
+        const float dy = apy - t * aby;
+        return dx * dx + dy * dy;
+    }
+}
+
+void polyline::simplify(const set& in, float epsilon, set& out) {
+    out.clear();
+    out.points.reserve(in.points.size());
+    const float epsilon2 = epsilon * epsilon;
+
+    thread_local std::vector<bool> keep;
+    thread_local std::vector<std::pair<size_t, size_t>> stack;
+    for (size_t k = 0; k < in.size(); ++k) {
+        const size_t begin = in.offsets[k];
+        const size_t end = in.offsets[k + 1];
+        if (end - begin <= 2) {
+            out.points.insert(out.points.end(), in.points.begin() + begin, in.points.begin() + end);
+            out.offsets.push_back(out.points.size());
+            continue;
+        }
+
+        keep.assign(end - begin, false);
+        keep.front() = true;
+        keep.back() = true;
+        stack.clear();
+        stack.push_back({begin, end - 1});
+        while (!stack.empty()) {
+            const auto [first, last] = stack.back();
+            stack.pop_back();
+            // the point farthest from the segment first -> last
+            float maxDistance = 0;
+            size_t index = first;
+            for (size_t i = first + 1; i < last; ++i) {
+                const float distance = segmentDistanceSquare(in.points[i], in.points[first], in.points[last]);
+                if (distance > maxDistance) {
+                    maxDistance = distance;
+                    index = i;
+                }
+            }
+            if (maxDistance > epsilon2) {
+                keep[index - begin] = true;
+                stack.push_back({first, index});
+                stack.push_back({index, last});
+            }
+        }
+
+        for (size_t i = begin; i < end; ++i)
+            if (keep[i - begin])
+                out.points.push_back(in.points[i]);
+        out.offsets.push_back(out.points.size());
+    }
+}
+
+void polyline::toPoints(const set& polylines, int r, int g, int b, std::vector<types::point<float>>& points) {
+    points.clear();
+    points.reserve(polylines.points.size());
+    for (size_t k = 0; k < polylines.size(); ++k) {
+        for (size_t i = polylines.offsets[k]; i < polylines.offsets[k + 1]; ++i) {
+            const types::xypoint<float>& p = polylines.points[i];
+            if (i == polylines.offsets[k])
+                points.push_back({p.first, p.second, 0, 0, 0, 255, true});
+            else
+                points.push_back({p.first, p.second, r, g, b, 255, true});
+        }
+    }
+}
\ No newline at end of file
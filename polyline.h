@@ -0,0 +1,76 @@
+/*
+ *  polyline.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <vector>
+#include <iterator>
+#include "point.h"
+#include "sort.h"
+
+// Post-processing of chained line segments (see sort::sortLines): consecutive segments that share an
+// endpoint are merged into polylines, which are then simplified with the Ramer-Douglas-Peucker algorithm.
+// The result can be converted into a point list for renderer::drawPoints.
+class polyline {
+public:
+    // a set of polylines stored in one contiguous array:
+    // polyline i consists of the points [offsets[i], offsets[i + 1])
+    struct set {
+        std::vector<types::xypoint<float>> points;
+        std::vector<size_t> offsets = {0};
+
+        // number of polylines
+        size_t size() const {
+            return offsets.size() - 1;
+        }
+
+        void clear() {
+            points.clear();
+            offsets.assign(1, 0);
+        }
+    };
+
+    // Merge chained lines into polylines: if the start point of a line is within tolerance of the end point
+    // of the previous line, the line continues the current polyline, otherwise a new polyline is started.
+    template<class RandomIt, class Accessor = lineAccessor<typename std::iterator_traits<RandomIt>::value_type>>
+    static void merge(RandomIt first, RandomIt last, float tolerance, set& polylines, Accessor accessor = Accessor()) {
+        polylines.clear();
+        const float tolerance2 = tolerance * tolerance;
+        for (RandomIt it = first; it != last; ++it) {
+            const types::xypoint<float> p0 = {static_cast<float>(accessor.x0(*it)), static_cast<float>(accessor.y0(*it))};
+            const types::xypoint<float> p1 = {static_cast<float>(accessor.x1(*it)), static_cast<float>(accessor.y1(*it))};
+            bool continues = false;
+            if (it != first) {
+                const types::xypoint<float>& end = polylines.points.back();
+                const float dx = p0.first - end.first;
+                const float dy = p0.second - end.second;
+                continues = dx * dx + dy * dy <= tolerance2;
+            }
+            if (!continues) {
+                if (it != first)
+                    polylines.offsets.push_back(polylines.points.size());
+                polylines.points.push_back(p0);
+            }
+            polylines.points.push_back(p1);
+        }
+        if (!polylines.points.empty())
+            polylines.offsets.push_back(polylines.points.size());
+    }
+
+    // Simplify every polyline with the Ramer-Douglas-Peucker algorithm: points that deviate less than
+    // epsilon from the simplified polyline are removed. The first and last point of each polyline are kept.
+    static void simplify(const set& in, float epsilon, set& out);
+
+    // merge and simplify in one step
+    template<class RandomIt, class Accessor = lineAccessor<typename std::iterator_traits<RandomIt>::value_type>>
+    static void fromLines(RandomIt first, RandomIt last, float tolerance, float epsilon, set& polylines, Accessor accessor = Accessor()) {
+        thread_local set merged;
+        merge(first, last, tolerance, merged, accessor);
+        simplify(merged, epsilon, polylines);
+    }
+
+    // Convert the polylines to a point list for renderer::drawPoints: the first point of every polyline is
+    // dark (blanked move from the previous polyline), the following points have the given color.
+    static void toPoints(const set& polylines, int r, int g, int b, std::vector<types::point<float>>& points);
+};
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "profiler.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+const std::chrono::steady_clock::time_point profiler::s_epoch = std::chrono::steady_clock::now();
+
+namespace {
+    // ring buffer of timings, written only by its thread
+    struct threadBuffer {
+        uint32_t id;
+        std::vector<profiler::event> events;
+        // number of events written so far (the buffer holds the last eventCapacity)
+        std::atomic<size_t> written{0};
+    };
+
+    struct state {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<threadBuffer>> threads;
+        profiler::counter counters[profiler::maxCounters];
+        std::atomic<size_t> numberOfCounters{0};
+        std::vector<profiler::frame> frames = std::vector<profiler::frame>(profiler::frameCapacity);
+        size_t framesWritten = 0;
+        std::atomic<uint32_t> frame{0};
+        int64_t frameStart = 0;
+    };
+
+    state& getState() {
+        static state s;
+        return s;
+    }
+
+    threadBuffer& getThreadBuffer() {
+        // the buffers are owned by the state, so the timings outlive the threads
+        thread_local threadBuffer* buffer = nullptr;
+        if (!buffer) {
+            state& s = getState();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.threads.push_back(std::make_unique<threadBuffer>());
+            buffer = s.threads.back().get();
+            buffer->id = static_cast<uint32_t>(s.threads.size() - 1);
+            buffer->events.resize(profiler::eventCapacity);
+        }
+        return *buffer;
+    }
+
+    // escape a name for JSON
+    void writeString(FILE* file, const char* str) {
+        std::fputc('"', file);
+        for (; *str; ++str) {
+            if (*str == '"' || *str == '\\')
+                std::fputc('\\', file);
+            std::fputc(*str, file);
+        }
+        std::fputc('"', file);
+    }
+}
+
+void profiler::record(const char* name, int64_t start, int64_t duration) {
+    threadBuffer& buffer = getThreadBuffer();
+    const size_t n = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[n % eventCapacity] = {name, start, duration, getState().frame.load(std::memory_order_relaxed)};
+    buffer.written.store(n + 1, std::memory_order_release);
+}
+
+profiler::counter& profiler::getCounter(const char* name) {
+    state& s = getState();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    const size_t n = s.numberOfCounters.load();
+    for (size_t i = 0; i < n; ++i)
+        if (std::strcmp(s.counters[i].name, name) == 0)
+            return s.counters[i];
+    // if there are too many counters, the last one collects the rest
+    if (n == maxCounters)
+        return s.counters[maxCounters - 1];
+    s.counters[n].name = name;
+    s.counters[n].value = 0;
+    s.numberOfCounters.store(n + 1);
+    return s.counters[n];
+}
+
+void profiler::nextFrame() {
+    state& s = getState();
+    const int64_t t = now();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    frame& f = s.frames[s.framesWritten % frameCapacity];
+    f.index = s.frame.load();
+    f.start = s.frameStart;
+    f.duration = t - s.frameStart;
+    const size_t n = s.numberOfCounters.load();
+    for (size_t i = 0; i < maxCounters; ++i)
+        f.counters[i] = i < n ? s.counters[i].value.exchange(0, std::memory_order_relaxed) : 0;
+    s.framesWritten++;
+    s.frameStart = t;
+    s.frame.fetch_add(1);
+}
+
+uint32_t profiler::currentFrame() {
+    return getState().frame.load();
+}
+
+void profiler::getFrames(std::vector<frame>& frames) {
+    state& s = getState();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    frames.clear();
+    const size_t first = s.framesWritten > frameCapacity ? s.framesWritten - frameCapacity : 0;
+    for (size_t i = first; i < s.framesWritten; ++i)
+        frames.push_back(s.frames[i % frameCapacity]);
+}
+
+void profiler::getCounterNames(std::vector<const char*>& names) {
+    state& s = getState();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    names.clear();
+    for (size_t i = 0; i < s.numberOfCounters.load(); ++i)
+        names.push_back(s.counters[i].name);
+}
+
+bool profiler::exportChromeTrace(const std::string& filename) {
+    std::vector<frame> frames;
+    std::vector<const char*> names;
+    getFrames(frames);
+    getCounterNames(names);
+
+    FILE* file = std::fopen(filename.c_str(), "w");
+    if (!file)
+        return false;
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    auto separator = [&]() {
+        if (!first)
+            std::fprintf(file, ",\n");
+        first = false;
+    };
+
+    // timings as complete events ("X"), the timestamps are in microseconds
+    state& s = getState();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (const std::unique_ptr<threadBuffer>& buffer : s.threads) {
+            const size_t written = buffer->written.load(std::memory_order_acquire);
+            const size_t begin = written > eventCapacity ? written - eventCapacity : 0;
+            for (size_t i = begin; i < written; ++i) {
+                const event& e = buffer->events[i % eventCapacity];
+                separator();
+                std::fprintf(file, "{\"name\":");
+                writeString(file, e.name);
+                std::fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+                             buffer->id, e.start / 1000.0, e.duration / 1000.0, e.frame);
+            }
+        }
+    }
+
+    // frames as complete events on their own track and the counters as counter events ("C") at the start of the frame
+    for (const frame& f : frames) {
+        separator();
+        std::fprintf(file, "{\"name\":\"frame %u\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}", f.index, f.start / 1000.0, f.duration / 1000.0);
+        for (size_t i = 0; i < names.size(); ++i) {
+            separator();
+            std::fprintf(file, "{\"name\":");
+            writeString(file, names[i]);
+            std::fprintf(file, ",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%lld}}", f.start / 1000.0, static_cast<long long>(f.counters[i]));
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+void profiler::reset() {
+    state& s = getState();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (std::unique_ptr<threadBuffer>& buffer : s.threads)
+        buffer->written.store(0);
+    s.framesWritten = 0;
+    s.frameStart = now();
+    for (size_t i = 0; i < s.numberOfCounters.load(); ++i)
+        s.counters[i].value = 0;
+}
\ No newline at end of file
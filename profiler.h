@@ -0,0 +1,113 @@
+/*
+ *  profiler.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Low overhead instrumentation of the hot paths. Define PROFILING to enable it, otherwise all macros compile to nothing.
+//   PROFILE_SCOPE("name")         time the enclosing scope
+//   PROFILE_COUNT("name", value)  add value to a counter of the current frame
+//   PROFILE_FRAME()               close the current frame (call once per frame, e.g. after presenting it)
+// The names must be string literals (or have static storage duration).
+// The timings are stored per thread in ring buffers, the counters in a ring buffer of frames. Both can be
+// exported with profiler::exportChromeTrace and viewed in chrome://tracing or https://ui.perfetto.dev.
+#ifdef PROFILING
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) profiler::scopedTimer PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNT(name, value) do { static profiler::counter& PROFILE_CONCAT(profileCounter, __LINE__) = profiler::getCounter(name); \
+                                        PROFILE_CONCAT(profileCounter, __LINE__).add(value); } while (0)
+#define PROFILE_FRAME() profiler::nextFrame()
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COUNT(name, value) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
+
+class profiler {
+public:
+    // number of timings kept per thread and number of frames kept for the counters
+    static constexpr size_t eventCapacity = 1 << 16;
+    static constexpr size_t frameCapacity = 256;
+    static constexpr size_t maxCounters = 32;
+
+    // a timed scope
+    struct event {
+        const char* name;
+        // nanoseconds since the start of the profiler
+        int64_t start;
+        int64_t duration;
+        uint32_t frame;
+    };
+
+    // the counters and the duration of a frame
+    struct frame {
+        uint32_t index;
+        int64_t start;
+        int64_t duration;
+        int64_t counters[maxCounters];
+    };
+
+    struct counter {
+        const char* name;
+        std::atomic<int64_t> value;
+
+        void add(int64_t n) {
+            value.fetch_add(n, std::memory_order_relaxed);
+        }
+    };
+
+    class scopedTimer {
+    public:
+        explicit scopedTimer(const char* name) : m_name(name), m_start(now()) {}
+        ~scopedTimer() {
+            record(m_name, m_start, now() - m_start);
+        }
+        scopedTimer(const scopedTimer&) = delete;
+        scopedTimer& operator=(const scopedTimer&) = delete;
+
+    private:
+        const char* m_name;
+        int64_t m_start;
+    };
+
+    // nanoseconds since the start of the profiler
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_epoch).count();
+    }
+
+    // store a timing in the ring buffer of the calling thread
+    static void record(const char* name, int64_t start, int64_t duration);
+
+    // the counter with the given name (created on first use, at most maxCounters)
+    static counter& getCounter(const char* name);
+
+    // store the counters of the current frame and reset them
+    static void nextFrame();
+
+    // index of the current frame
+    static uint32_t currentFrame();
+
+    // the last frames (oldest first), at most frameCapacity
+    static void getFrames(std::vector<frame>& frames);
+
+    // the names of the counters, the index corresponds to frame::counters
+    static void getCounterNames(std::vector<const char*>& names);
+
+    // write all timings and counters as Chrome trace (JSON), returns false on error.
+    // Should be called while no instrumented code is running (e.g. between two frames).
+    static bool exportChromeTrace(const std::string& filename);
+
+    // remove all timings and frames
+    static void reset();
+
+private:
+    static const std::chrono::steady_clock::time_point s_epoch;
+};
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "raster.h"
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include "algorithms.h"
+#include "parallel.h"
+
+rasterBackend::rasterBackend(int width, int height, unsigned int numberOfThreads, int tileSize)
+    : m_width(0), m_height(0), m_threads(numberOfThreads), m_tileSize(std::max(tileSize, 8)), m_tilesX(0), m_tilesY(0), m_background(pack(0, 0, 0, 255)) {
+    if (m_threads == 0) {
+        const unsigned int hw = std::thread::hardware_concurrency();
+        m_threads = hw > 0 ? hw : 1;
+    }
+    resize(width, height);
+}
+
+void rasterBackend::resize(int width, int height) {
+    m_width = std::max(width, 0);
+    m_height = std::max(height, 0);
+    m_pixels.assign(static_cast<size_t>(m_width) * m_height, m_background);
+    m_tilesX = (m_width + m_tileSize - 1) / m_tileSize;
+    m_tilesY = (m_height + m_tileSize - 1) / m_tileSize;
+    m_bins.resize(static_cast<size_t>(m_tilesX) * m_tilesY);
+}
+
+void rasterBackend::setBackground(int r, int g, int b, int a) {
+    m_background = pack(r, g, b, a);
+}
+
+int rasterBackend::width() const {
+    return m_width;
+}
+
+int rasterBackend::height() const {
+    return m_height;
+}
+
+const uint8_t* rasterBackend::data() const {
+    return reinterpret_cast<const uint8_t*>(m_pixels.data());
+}
+
+uint32_t rasterBackend::pixel(int x, int y) const {
+    return m_pixels[static_cast<size_t>(y) * m_width + x];
+}
+
+uint32_t rasterBackend::pack(int r, int g, int b, int a) {
+    return static_cast<uint32_t>(algorithms::constrain(r, 0, 255)) |
+           static_cast<uint32_t>(algorithms::constrain(g, 0, 255)) << 8 |
+           static_cast<uint32_t>(algorithms::constrain(b, 0, 255)) << 16 |
+           static_cast<uint32_t>(algorithms::constrain(a, 0, 255)) << 24;
+}
+
+bool rasterBackend::save(const std::string& filename) const {
+    FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file)
+        return false;
+    std::fprintf(file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", m_width, m_height);
+    // the pixels are stored as bytes r, g, b, a on little endian machines
+    std::vector<uint8_t> row(static_cast<size_t>(m_width) * 4);
+    bool ok = true;
+    for (int y = 0; y < m_height && ok; ++y) {
+        for (int x = 0; x < m_width; ++x) {
+            const uint32_t c = pixel(x, y);
+            row[4 * x + 0] = c & 0xff;
+            row[4 * x + 1] = (c >> 8) & 0xff;
+            row[4 * x + 2] = (c >> 16) & 0xff;
+            row[4 * x + 3] = c >> 24;
+        }
+        ok = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+    }
+    std::fclose(file);
+    return ok;
+}
+
+void rasterBackend::drawFrame(const frameGeometry& frame) {
+    // collect the primitives
+    m_ellipses.clear();
+    m_segments.clear();
+    m_particles.clear();
+    for (const frameGeometry::ellipse& e : frame.ellipses)
+        m_ellipses.push_back({e.x, e.y, e.rx, e.ry, pack(e.r, e.g, e.b, e.a)});
+    for (const frameGeometry::particle& p : frame.particles)
+        m_particles.push_back({p.x, p.y, p.size, p.size, pack(p.r, p.g, p.b, p.a)});
+    for (const frameGeometry::polylineRange& p : frame.polylines) {
+        for (size_t i = p.first + 1; i < p.last; ++i) {
+            const types::point<float>& a = frame.points[i - 1];
+            const types::point<float>& b = frame.points[i];
+            m_segments.push_back({a.x, a.y, b.x, b.y, pack(b.r, b.g, b.b, b.a)});
+        }
+    }
+
+    // bin them into the tiles in the order of sdlBackend: ellipses below the lines, particles on top
+    for (std::vector<uint32_t>& b : m_bins)
+        b.clear();
+    for (size_t i = 0; i < m_ellipses.size(); ++i) {
+        const ellipse& e = m_ellipses[i];
+        bin(e.x - e.rx, e.y - e.ry, e.x + e.rx, e.y + e.ry, static_cast<uint32_t>(i));
+    }
+    for (size_t i = 0; i < m_segments.size(); ++i) {
+        const segment& s = m_segments[i];
+        // anti-aliased lines touch one pixel next to the ideal line
+        bin(std::min(s.x0, s.x1) - 1, std::min(s.y0, s.y1) - 1, std::max(s.x0, s.x1) + 1, std::max(s.y0, s.y1) + 1, static_cast<uint32_t>(m_ellipses.size() + i));
+    }
+    for (size_t i = 0; i < m_particles.size(); ++i) {
+        const ellipse& p = m_particles[i];
+        bin(p.x - p.rx, p.y - p.ry, p.x + p.rx, p.y + p.ry, static_cast<uint32_t>(m_ellipses.size() + m_segments.size() + i));
+    }
+
+    // rasterize the tiles, every thread writes only to the pixels of its own tiles
+    math::utilities::parallelFor(0, m_bins.size(), m_threads, [this](size_t begin, size_t end, unsigned int) {
+        for (size_t t = begin; t < end; ++t)
+            rasterizeTile(t);
+    });
+}
+
+void rasterBackend::bin(float xmin, float ymin, float xmax, float ymax, uint32_t primitive) {
+    if (xmax < 0 || ymax < 0 || xmin >= m_width || ymin >= m_height)
+        return;
+    const int tx0 = std::max(static_cast<int>(xmin) / m_tileSize, 0);
+    const int ty0 = std::max(static_cast<int>(ymin) / m_tileSize, 0);
+    const int tx1 = std::min(static_cast<int>(xmax) / m_tileSize, m_tilesX - 1);
+    const int ty1 = std::min(static_cast<int>(ymax) / m_tileSize, m_tilesY - 1);
+    for (int ty = ty0; ty <= ty1; ++ty)
+        for (int tx = tx0; tx <= tx1; ++tx)
+            m_bins[static_cast<size_t>(ty) * m_tilesX + tx].push_back(primitive);
+}
+
+void rasterBackend::rasterizeTile(size_t t) {
+    const int tx = static_cast<int>(t % m_tilesX);
+    const int ty = static_cast<int>(t / m_tilesX);
+    const tile rect = {tx * m_tileSize, ty * m_tileSize, std::min((tx + 1) * m_tileSize, m_width), std::min((ty + 1) * m_tileSize, m_height)};
+    for (int y = rect.y0; y < rect.y1; ++y)
+        std::fill(m_pixels.begin() + static_cast<size_t>(y) * m_width + rect.x0, m_pixels.begin() + static_cast<size_t>(y) * m_width + rect.x1, m_background);
+    for (uint32_t primitive : m_bins[t]) {
+        if (primitive < m_ellipses.size())
+            fillEllipse(m_ellipses[primitive], rect);
+        else if (primitive < m_ellipses.size() + m_segments.size())
+            drawLine(m_segments[primitive - m_ellipses.size()], rect);
+        else
+            fillEllipse(m_particles[primitive - m_ellipses.size() - m_segments.size()], rect);
+    }
+}
+
+void rasterBackend::fillEllipse(const ellipse& e, const tile& t) {
+    if (e.rx <= 0 || e.ry <= 0)
+        return;
+    const int y0 = std::max(t.y0, static_cast<int>(std::ceil(e.y - e.ry - 0.5f)));
+    const int y1 = std::min(t.y1, static_cast<int>(std::floor(e.y + e.ry - 0.5f)) + 1);
+    for (int y = y0; y < y1; ++y) {
+        // horizontal extent of the ellipse at the center of the pixel row
+        const float v = (y + 0.5f - e.y) / e.ry;
+        const float w = 1 - v * v;
+        if (w < 0)
+            continue;
+        const float dx = e.rx * std::sqrt(w);
+        const int x0 = std::max(t.x0, static_cast<int>(std::ceil(e.x - dx - 0.5f)));
+        const int x1 = std::min(t.x1, static_cast<int>(std::floor(e.x + dx - 0.5f)) + 1);
+        if (x0 < x1)
+            fillSpan(m_pixels.data() + static_cast<size_t>(y) * m_width, x0, x1, e.color);
+    }
+}
+
+void rasterBackend::fillSpan(uint32_t* row, int x0, int x1, uint32_t color) {
+    const uint32_t a = color >> 24;
+    if (a == 255) {
+        std::fill(row + x0, row + x1, color);
+        return;
+    }
+    if (a == 0)
+        return;
+    // blend the span: dst = src * a + dst * (1 - a), per channel in 8 bit fixed point
+    const uint32_t ia = 255 - a;
+    const uint32_t sr = (color & 0xff) * a, sg = ((color >> 8) & 0xff) * a, sb = ((color >> 16) & 0xff) * a;
+    ALGORITHMS_PRAGMA(omp simd)
+    for (int x = x0; x < x1; ++x) {
+        const uint32_t d = row[x];
+        const uint32_t r = (sr + (d & 0xff) * ia) / 255;
+        const uint32_t g = (sg + ((d >> 8) & 0xff) * ia) / 255;
+        const uint32_t b = (sb + ((d >> 16) & 0xff) * ia) / 255;
+        const uint32_t da = d >> 24;
+        const uint32_t oa = a + da * ia / 255;
+        row[x] = r | g << 8 | b << 16 | oa << 24;
+    }
+}
+
+void rasterBackend::blend(int x, int y, uint32_t color, float coverage) {
+    const uint32_t a = static_cast<uint32_t>((color >> 24) * coverage + 0.5f);
+    if (a == 0)
+        return;
+    uint32_t& d = m_pixels[static_cast<size_t>(y) * m_width + x];
+    const uint32_t ia = 255 - a;
+    const uint32_t r = ((color & 0xff) * a + (d & 0xff) * ia) / 255;
+    const uint32_t g = (((color >> 8) & 0xff) * a + ((d >> 8) & 0xff) * ia) / 255;
+    const uint32_t b = (((color >> 16) & 0xff) * a + ((d >> 16) & 0xff) * ia) / 255;
+    const uint32_t oa = a + (d >> 24) * ia / 255;
+    d = r | g << 8 | b << 16 | oa << 24;
+}
+
+void rasterBackend::drawLine(const segment& s, const tile& t) {
+    // Xiaolin Wu's line algorithm, restricted to the part of the line inside the tile.
+    // Pixel centers lie at integer + 0.5 (like the ellipses).
+    float x0 = s.x0 - 0.5f, y0 = s.y0 - 0.5f, x1 = s.x1 - 0.5f, y1 = s.y1 - 0.5f;
+    const bool steep = std::abs(y1 - y0) > std::abs(x1 - x0);
+    if (steep) {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    const float dx = x1 - x0;
+    const float gradient = dx > 0 ? (y1 - y0) / dx : 1;
+
+    // range of the major axis inside the tile
+    const int majorMin = steep ? t.y0 : t.x0;
+    const int majorMax = steep ? t.y1 : t.x1;
+    const int minorMin = steep ? t.x0 : t.y0;
+    const int minorMax = steep ? t.x1 : t.y1;
+    const int start = std::max(static_cast<int>(std::lround(x0)), majorMin);
+    const int end = std::min(static_cast<int>(std::lround(x1)), majorMax - 1);
+    for (int x = start; x <= end; ++x) {
+        const float y = y0 + gradient * (x - x0);
+        const int yi = static_cast<int>(std::floor(y));
+        const float f = y - yi;
+        if (yi >= minorMin && yi < minorMax) {
+            if (steep)
+                blend(yi, x, s.color, 1 - f);
+            else
+                blend(x, yi, s.color, 1 - f);
+        }
+        if (yi + 1 >= minorMin && yi + 1 < minorMax) {
+            if (steep)
+                blend(yi + 1, x, s.color, f);
+            else
+                blend(x, yi + 1, s.color, f);
+        }
+    }
+}
\ No newline at end of file
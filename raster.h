@@ -0,0 +1,76 @@
+/*
+ *  raster.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "backend.h"
+
+// Software rasterizer that draws the frames into a RGBA memory buffer (e.g. for headless rendering).
+// Polylines are drawn as anti-aliased lines (Xiaolin Wu), ellipses and particles are filled span by span
+// (ellipses below the lines, particles on top, like sdlBackend).
+// The screen is divided into tiles, the primitives are binned into the tiles and the tiles are rasterized in parallel.
+class rasterBackend : public renderBackend {
+public:
+    // numberOfThreads: 0 = std::thread::hardware_concurrency()
+    rasterBackend(int width, int height, unsigned int numberOfThreads = 1, int tileSize = 64);
+
+    // clears the buffer with the background color and draws the frame
+    void drawFrame(const frameGeometry& frame) override;
+
+    void resize(int width, int height);
+    void setBackground(int r, int g, int b, int a = 255);
+
+    int width() const;
+    int height() const;
+    // the pixels, row by row, 4 bytes (r, g, b, a) per pixel
+    const uint8_t* data() const;
+    // color of a pixel as r | g << 8 | b << 16 | a << 24
+    uint32_t pixel(int x, int y) const;
+
+    // write the buffer as binary PAM (RGB_ALPHA) file, returns false on error
+    bool save(const std::string& filename) const;
+
+    static uint32_t pack(int r, int g, int b, int a);
+
+private:
+    struct segment {
+        float x0, y0, x1, y1;
+        uint32_t color;
+    };
+
+    struct tile {
+        int x0, y0, x1, y1;
+    };
+
+    struct ellipse {
+        float x, y, rx, ry;
+        uint32_t color;
+    };
+
+    void bin(float xmin, float ymin, float xmax, float ymax, uint32_t primitive);
+    void rasterizeTile(size_t t);
+    void fillEllipse(const ellipse& e, const tile& t);
+    void drawLine(const segment& s, const tile& t);
+    void fillSpan(uint32_t* row, int x0, int x1, uint32_t color);
+    void blend(int x, int y, uint32_t color, float coverage);
+
+    int m_width;
+    int m_height;
+    unsigned int m_threads;
+    int m_tileSize;
+    int m_tilesX;
+    int m_tilesY;
+    uint32_t m_background;
+    std::vector<uint32_t> m_pixels;
+    std::vector<segment> m_segments;
+    std::vector<ellipse> m_ellipses;
+    std::vector<ellipse> m_particles;
+    // primitives of every tile in drawing order: ellipses are stored as index, segments as m_ellipses.size() + index
+    // and particles as m_ellipses.size() + m_segments.size() + index
+    std::vector<std::vector<uint32_t>> m_bins;
+};
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "raycast.h"
+#include <cmath>
+
+raycast::ray raycast::segment(const types::xypoint<float>& p, const types::xypoint<float>& q) {
+    return {p, {q.first - p.first, q.second - p.second}, 1};
+}
+
+bool raycast::firstHit(const object& o, const ray& r, hit& h) {
+    h.o = nullptr;
+    h.fraction = r.maxFraction;
+    if (o.npoints() == 0) {
+        const float fraction = circleIntersection(r, o.getCenterXY(), o.radius());
+        if (fraction < 0)
+            return false;
+        fillHit(o, r, fraction, -1, o.getCenterXY(), o.getCenterXY(), h);
+        return true;
+    }
+
+    types::xypoint<float> a = o.getPointXYUnchecked(0);
+    bool aCollidable = o.isCollidableUnchecked(0);
+    for (int i = 1; i < o.npoints(); ++i) {
+        const types::xypoint<float> b = o.getPointXYUnchecked(i);
+        const bool bCollidable = o.isCollidableUnchecked(i);
+        if (aCollidable && bCollidable) {
+            const float fraction = edgeIntersection(r, a, b);
+            if (fraction >= 0 && fraction <= h.fraction)
+                fillHit(o, r, fraction, i - 1, a, b, h);
+        }
+        a = b;
+        aCollidable = bCollidable;
+    }
+    return h.o != nullptr;
+}
+
+void raycast::allHits(const object& o, const ray& r, std::vector<hit>& hits) {
+    hit h;
+    if (o.npoints() == 0) {
+        // a ray can enter and leave a circle, only the entry is reported
+        const float fraction = circleIntersection(r, o.getCenterXY(), o.radius());
+        if (fraction >= 0) {
+            fillHit(o, r, fraction, -1, o.getCenterXY(), o.getCenterXY(), h);
+            hits.push_back(h);
+        }
+        return;
+    }
+
+    types::xypoint<float> a = o.getPointXYUnchecked(0);
+    bool aCollidable = o.isCollidableUnchecked(0);
+    for (int i = 1; i < o.npoints(); ++i) {
+        const types::xypoint<float> b = o.getPointXYUnchecked(i);
+        const bool bCollidable = o.isCollidableUnchecked(i);
+        if (aCollidable && bCollidable) {
+            const float fraction = edgeIntersection(r, a, b);
+            if (fraction >= 0) {
+                fillHit(o, r, fraction, i - 1, a, b, h);
+                hits.push_back(h);
+            }
+        }
+        a = b;
+        aCollidable = bCollidable;
+    }
+}
+
+raycast::objectList::objectList(const std::vector<object*>& objects) : m_objects(objects) {}
+
+bool raycast::circleOverlaps(const object& o, const types::xypoint<float>& origin, const types::xypoint<float>& direction, float maxFraction) {
+    // distance of the center to the closest point of the segment
+    const float dd = direction.first * direction.first + direction.second * direction.second;
+    const float cx = o.x() - origin.first;
+    const float cy = o.y() - origin.second;
+    float t = dd > 0 ? (cx * direction.first + cy * direction.second) / dd : 0;
+    t = std::min(std::max(t, 0.0f), maxFraction);
+    const float dx = cx - t * direction.first;
+    const float dy = cy - t * direction.second;
+    return dx * dx + dy * dy <= o.radiusSquare();
+}
+
+float raycast::edgeIntersection(const ray& r, const types::xypoint<float>& a, const types::xypoint<float>& b) {
+    const float ex = b.first - a.first;
+    const float ey = b.second - a.second;
+    const float denom = r.direction.first * ey - r.direction.second * ex;
+    if (std::abs(denom) <= std::numeric_limits<float>::epsilon())
+        return -1; // parallel
+    const float px = a.first - r.origin.first;
+    const float py = a.second - r.origin.second;
+    const float t = (px * ey - py * ex) / denom;
+    const float s = (px * r.direction.second - py * r.direction.first) / denom;
+    if (t < 0 || t > r.maxFraction || s < 0 || s > 1)
+        return -1;
+    return t;
+}
+
+float raycast::circleIntersection(const ray& r, const types::xypoint<float>& center, float radius) {
+    const float fx = r.origin.first - center.first;
+    const float fy = r.origin.second - center.second;
+    const float a = r.direction.first * r.direction.first + r.direction.second * r.direction.second;
+    const float b = 2 * (fx * r.direction.first + fy * r.direction.second);
+    const float c = fx * fx + fy * fy - radius * radius;
+    if (c <= 0)
+        return 0; // the ray starts inside of the circle
+    const float discriminant = b * b - 4 * a * c;
+    if (a <= 0 || discriminant < 0)
+        return -1;
+    const float t = (-b - std::sqrt(discriminant)) / (2 * a);
+    if (t < 0 || t > r.maxFraction)
+        return -1;
+    return t;
+}
+
+void raycast::fillHit(const object& o, const ray& r, float fraction, int edge, const types::xypoint<float>& a, const types::xypoint<float>& b, hit& h) {
+    h.o = const_cast<object*>(&o);
+    h.fraction = fraction;
+    h.point = {r.origin.first + fraction * r.direction.first, r.origin.second + fraction * r.direction.second};
+    h.edge = edge;
+    float nx, ny;
+    if (edge < 0) {
+        nx = h.point.first - a.first;
+        ny = h.point.second - a.second;
+    } else {
+        nx = -(b.second - a.second);
+        ny = b.first - a.first;
+    }
+    const float len = std::sqrt(nx * nx + ny * ny);
+    if (len > 0) {
+        nx /= len;
+        ny /= len;
+    } else {
+        // ray starts in the center of a circle
+        const float dlen = std::sqrt(r.direction.first * r.direction.first + r.direction.second * r.direction.second);
+        nx = dlen > 0 ? -r.direction.first / dlen : 0;
+        ny = dlen > 0 ? -r.direction.second / dlen : 0;
+    }
+    // the normal points against the ray
+    if (nx * r.direction.first + ny * r.direction.second > 0) {
+        nx = -nx;
+        ny = -ny;
+    }
+    h.normal = {nx, ny};
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+/*
+ *  raycast.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "object.h"
+#include "point.h"
+#include "parallel.h"
+
+class raycast {
+public:
+    // a ray or segment: origin + t * direction, 0 <= t <= maxFraction
+    // (a segment from p to q has direction q - p and maxFraction 1)
+    struct ray {
+        types::xypoint<float> origin;
+        types::xypoint<float> direction;
+        float maxFraction;
+    };
+
+    // the intersection of a ray with an object
+    struct hit {
+        // object that was hit, nullptr if the ray hit nothing
+        object* o;
+        // hit point = origin + fraction * direction
+        float fraction;
+        types::xypoint<float> point;
+        // unit normal of the edge that was hit, pointing against the ray
+        types::xypoint<float> normal;
+        // index of the first point of the edge that was hit, -1 for objects without points
+        int edge;
+    };
+
+    // build a ray from the segment p -> q
+    static ray segment(const types::xypoint<float>& p, const types::xypoint<float>& q);
+
+    // first intersection of a ray with the outline of an object. The edges are formed by consecutive
+    // collidable points (like they are drawn by the renderer), objects without points are circles with diameter hsize.
+    static bool firstHit(const object& o, const ray& r, hit& h);
+
+    // all intersections of a ray with the outline of an object, appended to hits (unsorted)
+    static void allHits(const object& o, const ray& r, std::vector<hit>& hits);
+
+    // first hit of the ray with any object of a spatial structure. The structure must provide
+    // raycast(origin, direction, maxFraction, callback), which calls callback(object*, maxFraction) or
+    // callback(object*, id, maxFraction) for every candidate and accepts the new maxFraction as return value
+    // (e.g. collisionWorld, aabbTree or raycast::objectList).
+    template<class World>
+    static bool firstHit(const World& world, const ray& r, hit& h) {
+        h.o = nullptr;
+        h.fraction = r.maxFraction;
+        hit candidate;
+        auto test = [&](object* o, float maxFraction) {
+            const ray clipped = {r.origin, r.direction, maxFraction};
+            // hits at maxFraction count like in the per object firstHit, among equal fractions the first candidate wins
+            if (firstHit(*o, clipped, candidate) && (!h.o || candidate.fraction < h.fraction))
+                h = candidate;
+            return h.o ? h.fraction : maxFraction;
+        };
+        world.raycast(r.origin, r.direction, r.maxFraction, candidateCallback<decltype(test)>{test});
+        return h.o != nullptr;
+    }
+
+    // all hits of the ray with the objects of a spatial structure, appended to hits and sorted by their fraction
+    template<class World>
+    static void allHits(const World& world, const ray& r, std::vector<hit>& hits) {
+        const size_t first = hits.size();
+        auto test = [&](object* o, float maxFraction) {
+            allHits(*o, r, hits);
+            return maxFraction;
+        };
+        world.raycast(r.origin, r.direction, r.maxFraction, candidateCallback<decltype(test)>{test});
+        std::sort(hits.begin() + first, hits.end(), [](const hit& a, const hit& b) { return a.fraction < b.fraction; });
+    }
+
+    // first hits of many rays at once, hits[i] belongs to rays[i] (hits[i].o == nullptr if the ray hit nothing).
+    // The rays are distributed over numberOfThreads threads, the queries of the world must be thread safe
+    // (which they are for aabbTree, collisionWorld and objectList).
+    template<class World>
+    static void firstHits(const World& world, const std::vector<ray>& rays, std::vector<hit>& hits, unsigned int numberOfThreads = 1) {
+        hits.resize(rays.size());
+        math::utilities::parallelFor(0, rays.size(), numberOfThreads, [&](size_t begin, size_t end, unsigned int) {
+            for (size_t i = begin; i < end; ++i)
+                firstHit(world, rays[i], hits[i]);
+        });
+    }
+
+    // brute force "acceleration structure" for a list of objects: every object whose bounding circle
+    // is hit by the ray is a candidate. Only a reference to the list is stored, it must outlive the objectList
+    // (temporary lists are rejected).
+    class objectList {
+    public:
+        objectList(const std::vector<object*>& objects);
+        objectList(std::vector<object*>&&) = delete;
+
+        template<class F>
+        void raycast(const types::xypoint<float>& origin, const types::xypoint<float>& direction, float maxFraction, F&& callback) const {
+            for (object* o : m_objects) {
+                if (!circleOverlaps(*o, origin, direction, maxFraction))
+                    continue;
+                const float fraction = callback(o, maxFraction);
+                if (fraction <= 0)
+                    return;
+                maxFraction = std::min(maxFraction, fraction);
+            }
+        }
+
+    private:
+        const std::vector<object*>& m_objects;
+    };
+
+private:
+    // forwards both callback signatures of the spatial structures to f(object*, maxFraction)
+    template<class F>
+    struct candidateCallback {
+        F& f;
+        float operator()(object* o, float maxFraction) const {
+            return f(o, maxFraction);
+        }
+        float operator()(object* o, int, float maxFraction) const {
+            return f(o, maxFraction);
+        }
+    };
+
+    // true if the ray hits the bounding circle of the object
+    static bool circleOverlaps(const object& o, const types::xypoint<float>& origin, const types::xypoint<float>& direction, float maxFraction);
+
+    // intersection of the ray with the edge a -> b, returns the fraction or a negative number if there is none
+    static float edgeIntersection(const ray& r, const types::xypoint<float>& a, const types::xypoint<float>& b);
+
+    // intersection of the ray with a circle, returns the fraction or a negative number if there is none
+    static float circleIntersection(const ray& r, const types::xypoint<float>& center, float radius);
+
+    static void fillHit(const object& o, const ray& r, float fraction, int edge, const types::xypoint<float>& a, const types::xypoint<float>& b, hit& h);
+};
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "recorder.h"
+#include <cstring>
+#include <algorithm>
+#include "algorithms.h"
+
+static_assert(sizeof(recordedPoint) == 10, "recordedPoint must not be padded");
+
+namespace {
+    constexpr size_t headerSize = sizeof(frameRecorder::magic) + sizeof(uint32_t);
+    constexpr size_t frameHeaderSize = 2 * sizeof(uint32_t);
+}
+
+frameRecorder::frameRecorder() : m_file(nullptr), m_frames(0) {
+}
+
+frameRecorder::~frameRecorder() {
+    close();
+}
+
+bool frameRecorder::open(const std::string& filename) {
+    close();
+    m_file = std::fopen(filename.c_str(), "wb");
+    if (!m_file)
+        return false;
+    // large buffer, a frame should not cause more than one write
+    std::setvbuf(m_file, nullptr, _IOFBF, 1 << 20);
+    m_frames = 0;
+    const uint32_t v = version;
+    if (std::fwrite(magic, sizeof(magic), 1, m_file) != 1 || std::fwrite(&v, sizeof(v), 1, m_file) != 1) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void frameRecorder::close() {
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+bool frameRecorder::isOpen() const {
+    return m_file != nullptr;
+}
+
+bool frameRecorder::writeFrame(const recordedPoint* points, size_t numberOfPoints, int scanSpeed) {
+    if (!m_file)
+        return false;
+    const uint32_t header[2] = {static_cast<uint32_t>(numberOfPoints), static_cast<uint32_t>(std::max(scanSpeed, 0))};
+    if (std::fwrite(header, sizeof(header), 1, m_file) != 1)
+        return false;
+    if (numberOfPoints > 0 && std::fwrite(points, sizeof(recordedPoint), numberOfPoints, m_file) != numberOfPoints)
+        return false;
+    m_frames++;
+    return true;
+}
+
+size_t frameRecorder::frames() const {
+    return m_frames;
+}
+
+uint16_t frameRecorder::toChannel(float value) {
+    return static_cast<uint16_t>(algorithms::constrain<float>(value, 0, 65535));
+}
+
+frameReplay::frameReplay() {
+}
+
+frameReplay::~frameReplay() {
+    close();
+}
+
+bool frameReplay::open(const std::string& filename) {
+    close();
+    if (!m_file.open(filename))
+        return false;
+    const unsigned char* data = m_file.data();
+    const size_t size = m_file.size();
+
+    // check the header and index the frames
+    uint32_t v = 0;
+    if (size < headerSize || std::memcmp(data, frameRecorder::magic, sizeof(frameRecorder::magic)) != 0) {
+        close();
+        return false;
+    }
+    std::memcpy(&v, data + sizeof(frameRecorder::magic), sizeof(v));
+    if (v != frameRecorder::version) {
+        close();
+        return false;
+    }
+    size_t offset = headerSize;
+    while (offset + frameHeaderSize <= size) {
+        uint32_t header[2];
+        std::memcpy(header, data + offset, sizeof(header));
+        const size_t end = offset + frameHeaderSize + static_cast<size_t>(header[0]) * sizeof(recordedPoint);
+        if (end > size)
+            break; // truncated frame (e.g. the recording was interrupted)
+        m_frames.push_back({offset + frameHeaderSize, header[0], static_cast<int>(header[1])});
+        offset = end;
+    }
+    return true;
+}
+
+void frameReplay::close() {
+    m_file.close();
+    m_frames.clear();
+}
+
+size_t frameReplay::frames() const {
+    return m_frames.size();
+}
+
+frameReplay::frame frameReplay::getFrame(size_t i) const {
+    const index& f = m_frames[i];
+    return {reinterpret_cast<const recordedPoint*>(m_file.data() + f.offset), f.numberOfPoints, f.scanSpeed};
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+/*
+ *  recorder.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "mappedfile.h"
+
+// A laser point in device coordinates (as sent to the Lumax device): x, y in [0, 65535], colors in [0, 65535]
+struct recordedPoint {
+    uint16_t x, y;
+    uint16_t r, g, b;
+};
+
+// File format (native byte order, no padding):
+//   header: char magic[4] = "LXFR", uint32 version
+//   frames: uint32 numberOfPoints, uint32 scanSpeed, recordedPoint points[numberOfPoints]
+// The points of a frame are stored contiguously, so a memory mapped file can be handed to a sink without copying.
+
+// Streaming recorder of laser frames, see renderer::lumaxRenderer::recorder
+class frameRecorder {
+public:
+    static constexpr char magic[4] = {'L', 'X', 'F', 'R'};
+    static constexpr uint32_t version = 1;
+
+    frameRecorder();
+    ~frameRecorder();
+    frameRecorder(const frameRecorder&) = delete;
+    frameRecorder& operator=(const frameRecorder&) = delete;
+
+    // create (or truncate) a file and write the header, returns false on error
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const;
+
+    // append a frame, returns false on error
+    bool writeFrame(const recordedPoint* points, size_t numberOfPoints, int scanSpeed);
+
+    // number of frames written since open
+    size_t frames() const;
+
+    // clamp a device coordinate or color to the range of a recorded point
+    static uint16_t toChannel(float value);
+
+private:
+    FILE* m_file;
+    size_t m_frames;
+};
+
+// Replay of a recorded file. The file is memory mapped (or read into memory on systems without mmap)
+// and indexed once when it is opened, the frames are then handed to a sink without copies.
+class frameReplay {
+public:
+    struct frame {
+        const recordedPoint* points;
+        size_t numberOfPoints;
+        int scanSpeed;
+    };
+
+    struct statistics {
+        size_t frames = 0;
+        size_t points = 0;
+        // wall clock time of the replay in seconds (including the time spent in the sink)
+        double seconds = 0;
+    };
+
+    frameReplay();
+    ~frameReplay();
+    frameReplay(const frameReplay&) = delete;
+    frameReplay& operator=(const frameReplay&) = delete;
+
+    // open and index a recorded file, returns false if the file cannot be read or is corrupt
+    bool open(const std::string& filename);
+    void close();
+
+    size_t frames() const;
+    frame getFrame(size_t i) const;
+
+    // push all frames repetitions times through sink(const frame&) as fast as possible.
+    // The replay stops early if the sink returns false.
+    template<class Sink>
+    statistics play(Sink&& sink, size_t repetitions = 1) const {
+        statistics stats;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < repetitions; ++k) {
+            for (size_t i = 0; i < m_frames.size(); ++i) {
+                const frame f = getFrame(i);
+                stats.frames++;
+                stats.points += f.numberOfPoints;
+                if (!sink(f)) {
+                    k = repetitions;
+                    break;
+                }
+            }
+        }
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+private:
+    struct index {
+        size_t offset;
+        size_t numberOfPoints;
+        int scanSpeed;
+    };
+
+    mappedFile m_file;
+    std::vector<index> m_frames;
+};
\ No newline at end of file
@@ -1,23 +1,27 @@
 #include "renderer.h"
 #include <SDL2_gfxPrimitives.h>
 #include <iostream>
-#include <chrono>
+#include <cmath>
+#include <algorithm>
 #include "algorithms.h"
+#include "profiler.h"
 
 int renderer::screen_width = 900;
 int renderer::screen_height = 800;
 
 void renderer::drawObject(const object& object, SDL_Renderer *ren) {
+    PROFILE_SCOPE("renderer::drawObject");
+    PROFILE_COUNT("points emitted", object.npoints());
     if (object.npoints() == 0) {
         // if the object consists only of one point, draw a filled circle
         types::point point = object.getCenter();
         filledEllipseRGBA(ren, (int)object.x(), (int)object.y(), (int)(object.hsize() / 2), (int)(object.vsize() / 2), point.r, point.g, point.b, point.a);
     } else {
-        types::point point = object.getPoint(0);
+        types::point point = object.getPointUnchecked(0);
         int xp_old = (int)(point.x);
         int yp_old = (int)(point.y);
         for (int i = 1; i < object.npoints(); ++i) {
-            point = object.getPoint(i);
+            point = object.getPointUnchecked(i);
             lineRGBA(ren, (int)point.x, (int)point.y, xp_old, yp_old, point.r, point.g, point.b, point.a);
             xp_old = (int)point.x;
             yp_old = (int)point.y;
@@ -37,67 +41,203 @@ float renderer::transform(float x, float x1, float x2, float y1, float y2) {
 }
 
 #ifdef LUMAX_OUTPUT
-void renderer::drawObject(const object& object, lumaxRenderer& ren) {
+void renderer::drawObject(const object& object, lumaxRenderer& ren, int priority) {
+    PROFILE_SCOPE("renderer::drawObject");
     // TODO: if objects consists only of one point (see above)
-    if (object.xcenter() >= 0 && object.xcenter() <= screen_width &&
+    if (object.npoints() > 0 &&
+        object.xcenter() >= 0 && object.xcenter() <= screen_width &&
         object.ycenter() >= 0 && object.ycenter() <= screen_height) {
-        types::point point = object.getPoint(0);
-        float xp_old = point.x;
-        float yp_old = point.y;
-        addPoint(ren, xp_old, yp_old, 0, 0, 0, ren.parameters.scalingX, ren.parameters.scalingY); // start with a dark point
-        for (int i = 0; i < object.npoints(); ++i) {
-            point = object.getPoint(i);
-            // Lumax has a 2^8 = 256 * 256 = 65536 color range
-            addPoint(ren, point.x, point.y, point.r * 256, point.g * 256, point.b * 256, ren.parameters.scalingX, ren.parameters.scalingY);
-            xp_old = point.x;
-            yp_old = point.y;
-        }
-        addPoint(ren, xp_old, yp_old, 0, 0, 0, ren.parameters.scalingX, ren.parameters.scalingY); // end with a dark point
+        thread_local std::vector<types::point<float>> points;
+        points.resize(object.npoints());
+        object.getPoints(points.data());
+        drawPolyline(points.data(), points.size(), ren, priority);
+        // including the dark start and end point
+        PROFILE_COUNT("points emitted", points.size() + 2);
     }
 }
 
-void renderer::drawPoints(std::vector<types::point<float>>& points, lumaxRenderer& ren) {
+void renderer::drawPolyline(const types::point<float>* points, size_t n, lumaxRenderer& ren, int priority) {
+    if (n == 0)
+        return;
+    const size_t first = ren.points.size();
+    addPoint(ren, points[0].x, points[0].y, 0, 0, 0); // start with a dark point
+    for (size_t i = 0; i < n; ++i) {
+        // Lumax has a 2^8 = 256 * 256 = 65536 color range
+        addPoint(ren, points[i].x, points[i].y, points[i].r * 256, points[i].g * 256, points[i].b * 256);
+    }
+    addPoint(ren, points[n - 1].x, points[n - 1].y, 0, 0, 0); // end with a dark point
+    transformPoints(updateTransform(ren), ren.points.data() + first, ren.points.size() - first);
+    ren.objects.push_back({first, ren.points.size(), priority});
+}
+
+void renderer::drawPoints(std::vector<types::point<float>>& points, lumaxRenderer& ren, int priority) {
     applyColorCorrection(ren, points);
+    const size_t first = ren.points.size();
     float xp_old = screen_width / 2;
     float yp_old = screen_height / 2;
-    addPoint(ren, xp_old, yp_old, 0, 0, 0, ren.parameters.scalingX, ren.parameters.scalingY); // start with a dark point
+    addPoint(ren, xp_old, yp_old, 0, 0, 0); // start with a dark point
     for (const types::point<float>& point : points) {
         // Lumax has a 2^8 = 256 * 256 = 65536 color range
-        addPoint(ren, point.x, point.y, point.r * 256, point.g * 256, point.b * 256, ren.parameters.scalingX, ren.parameters.scalingY);
+        addPoint(ren, point.x, point.y, point.r * 256, point.g * 256, point.b * 256);
         xp_old = point.x;
         yp_old = point.y;
     }
-    addPoint(ren, xp_old, yp_old, 0, 0, 0, ren.parameters.scalingX, ren.parameters.scalingY); // end with a dark point
+    addPoint(ren, xp_old, yp_old, 0, 0, 0); // end with a dark point
+    transformPoints(updateTransform(ren), ren.points.data() + first, ren.points.size() - first);
+    ren.objects.push_back({first, ren.points.size(), priority});
 }
 
 int renderer::sendPointsToLumax(void *lumaxHandle, lumaxRenderer& ren, int scanSpeed) {
-    if (!lumaxHandle) return -1;
+    PROFILE_SCOPE("renderer::sendPointsToLumax");
+    if (!lumaxHandle && !ren.recorder) return -1;
     //lumax_verbosity |= DBWAITFORBUFFER;
-    size_t numOfPoints = ren.points.size();
-    TLumax_Point points[numOfPoints];
-    for (int i = 0; i < numOfPoints; ++i) {
-        points[i].Ch1 = static_cast<int>(ren.points[i].x);
-        points[i].Ch2 = static_cast<int>(ren.points[i].y);
-        points[i].Ch3 = ren.points[i].r;
-        points[i].Ch4 = ren.points[i].g;
-        points[i].Ch5 = ren.points[i].b;
+    thread_local std::vector<types::point<float>> resampled;
+    governFrame(ren, scanSpeed, resampled);
+    size_t numOfPoints = resampled.size();
+    if (ren.recorder) {
+        thread_local std::vector<recordedPoint> recorded;
+        recorded.resize(numOfPoints);
+        for (size_t i = 0; i < numOfPoints; ++i) {
+            recorded[i] = {frameRecorder::toChannel(resampled[i].x), frameRecorder::toChannel(resampled[i].y),
+                frameRecorder::toChannel(resampled[i].r), frameRecorder::toChannel(resampled[i].g), frameRecorder::toChannel(resampled[i].b)};
+        }
+        ren.recorder->writeFrame(recorded.data(), numOfPoints, scanSpeed);
+    }
+    if (!lumaxHandle) {
+        ren.points.clear();
+        ren.objects.clear();
+        return 0;
+    }
+    thread_local std::vector<TLumax_Point> points;
+    points.resize(numOfPoints);
+    for (size_t i = 0; i < numOfPoints; ++i) {
+        points[i].Ch1 = static_cast<int>(resampled[i].x);
+        points[i].Ch2 = static_cast<int>(resampled[i].y);
+        points[i].Ch3 = resampled[i].r;
+        points[i].Ch4 = resampled[i].g;
+        points[i].Ch5 = resampled[i].b;
         points[i].Ch8 = 0;
         points[i].Ch6 = 0;
         points[i].Ch7 = 0;
     }
-    //auto start = std::chrono::high_resolution_clock::now();
-    Lumax_SendFrame(lumaxHandle, points, numOfPoints, scanSpeed, 0, NULL);
-    //auto stop = std::chrono::high_resolution_clock::now();
-    //auto duration = duration_cast<std::chrono::microseconds>(stop - start);
-    //std::cout << duration.count() / 1000 <<  "ms, " << static_cast<float>(1.0 / (duration.count() / 1000000.0)) << "Hz" << std::endl;
+    {
+        PROFILE_SCOPE("Lumax_SendFrame");
+        PROFILE_COUNT("points sent", numOfPoints);
+        Lumax_SendFrame(lumaxHandle, points.data(), numOfPoints, scanSpeed, 0, NULL);
+    }
 
     //int TimeToWait, BufferChanged;
     //result = Lumax_WaitForBuffer(lumaxHandle, 17, &TimeToWait, &BufferChanged);
     //std::cout << "TimeToWait = " << TimeToWait << std::endl;
     ren.points.clear();
+    ren.objects.clear();
     return 0;
 }
 
+int renderer::sendFrameToLumax(void *lumaxHandle, const frameReplay::frame& frame) {
+    if (!lumaxHandle) return -1;
+    thread_local std::vector<TLumax_Point> points;
+    points.resize(frame.numberOfPoints);
+    for (size_t i = 0; i < frame.numberOfPoints; ++i) {
+        points[i].Ch1 = frame.points[i].x;
+        points[i].Ch2 = frame.points[i].y;
+        points[i].Ch3 = frame.points[i].r;
+        points[i].Ch4 = frame.points[i].g;
+        points[i].Ch5 = frame.points[i].b;
+        points[i].Ch8 = 0;
+        points[i].Ch6 = 0;
+        points[i].Ch7 = 0;
+    }
+    Lumax_SendFrame(lumaxHandle, points.data(), frame.numberOfPoints, frame.scanSpeed, 0, NULL);
+    return 0;
+}
+
+void renderer::resample(const std::vector<types::point<float>>& points, const lumaxParameters& parameters, std::vector<types::point<float>>& resampled) {
+    resampled.clear();
+    resampled.reserve(resamplePoints(points, parameters, nullptr));
+    resamplePoints(points, parameters, &resampled);
+}
+
+renderer::frameEstimate renderer::estimateFrame(const lumaxRenderer& ren, int scanSpeed) {
+    frameEstimate estimate;
+    estimate.points = resamplePoints(ren.points, ren.parameters, nullptr);
+    estimate.drawTime = scanSpeed > 0 ? static_cast<float>(estimate.points) / scanSpeed : 0;
+    estimate.frameRate = estimate.drawTime > 0 ? 1 / estimate.drawTime : 0;
+    return estimate;
+}
+
+void renderer::governFrame(lumaxRenderer& ren, int scanSpeed, std::vector<types::point<float>>& resampled) {
+    frameStatistics& statistics = ren.statistics;
+    statistics = frameStatistics();
+    const size_t budget = ren.parameters.targetFrameRate > 0 && scanSpeed > 0 ? static_cast<size_t>(scanSpeed / ren.parameters.targetFrameRate) : 0;
+    size_t n = resamplePoints(ren.points, ren.parameters, nullptr);
+
+    if (budget > 0 && n > budget) {
+        // 1. reduce the resampling density
+        lumaxParameters parameters = ren.parameters;
+        const float minDensity = algorithms::constrain<float>(ren.parameters.minDensity, 0.01f, 1);
+        while (n > budget && statistics.density > minDensity) {
+            statistics.density = std::max(statistics.density * 0.8f, minDensity);
+            parameters = scaledParameters(ren.parameters, statistics.density);
+            n = resamplePoints(ren.points, parameters, nullptr);
+        }
+
+        // 2. drop objects, lowest priority first (and the last drawn first among equal priorities)
+        if (n > budget && !ren.objects.empty()) {
+            thread_local std::vector<size_t> order;
+            thread_local std::vector<bool> dropped;
+            thread_local std::vector<types::point<float>> kept;
+            thread_local std::vector<types::point<float>> range;
+            order.resize(ren.objects.size());
+            for (size_t i = 0; i < order.size(); ++i)
+                order[i] = order.size() - 1 - i;
+            std::stable_sort(order.begin(), order.end(), [&ren](size_t a, size_t b) { return ren.objects[a].priority < ren.objects[b].priority; });
+            dropped.assign(ren.objects.size(), false);
+            // the cost of an object is estimated by resampling it together with the move to its first point,
+            // the object with the highest priority is always kept
+            for (size_t i = 0; i + 1 < order.size() && n > budget; ++i) {
+                const objectRange& o = ren.objects[order[i]];
+                const size_t first = o.first > 0 ? o.first - 1 : 0;
+                range.assign(ren.points.begin() + first, ren.points.begin() + o.last);
+                const size_t cost = resamplePoints(range, parameters, nullptr) - (o.first - first);
+                dropped[order[i]] = true;
+                statistics.droppedObjects++;
+                statistics.droppedPoints += o.last - o.first;
+                n = n > cost ? n - cost : 0;
+            }
+
+            kept.clear();
+            kept.reserve(ren.points.size());
+            size_t next = 0;
+            for (size_t i = 0; i < ren.objects.size(); ++i) {
+                const objectRange& o = ren.objects[i];
+                if (!dropped[i])
+                    continue;
+                kept.insert(kept.end(), ren.points.begin() + next, ren.points.begin() + o.first);
+                next = o.last;
+            }
+            kept.insert(kept.end(), ren.points.begin() + next, ren.points.end());
+            resample(kept, parameters, resampled);
+        } else {
+            resample(ren.points, parameters, resampled);
+        }
+    } else {
+        resample(ren.points, ren.parameters, resampled);
+    }
+
+    statistics.points = resampled.size();
+    statistics.frameRate = scanSpeed > 0 && statistics.points > 0 ? static_cast<float>(scanSpeed) / statistics.points : 0;
+}
+
+renderer::lumaxParameters renderer::scaledParameters(const lumaxParameters& parameters, float density) {
+    lumaxParameters scaled = parameters;
+    scaled.maxStep = parameters.maxStep / density;
+    scaled.maxBlankStep = parameters.maxBlankStep / density;
+    scaled.cornerDwell = static_cast<int>(parameters.cornerDwell * density);
+    scaled.blankDwell = static_cast<int>(parameters.blankDwell * density);
+    return scaled;
+}
+
 void renderer::applyColorCorrection(const lumaxRenderer& ren, std::vector<types::point<float>>& points) {
     for (auto& p : points) {
         // do color correction only if at least one laser is on
@@ -112,21 +252,108 @@ void renderer::applyColorCorrection(const lumaxRenderer& ren, std::vector<types:
     }
 }
 
-void renderer::addPoint(lumaxRenderer& ren, float x, float y, int r, int g, int b, float xScaling, float yScaling) {
-    const float mid = ren.parameters.maxPositions / 2;
-    if (ren.parameters.swapXY == 1) {
-      int temp = y;
-      y = x;
-      x = temp;
+void renderer::addPoint(lumaxRenderer& ren, float x, float y, int r, int g, int b) {
+    ren.points.push_back({x, y, r, g, b, 1, false});
+}
+
+const renderer::affineTransform& renderer::updateTransform(lumaxRenderer& ren) {
+    affineTransform& t = ren.transform;
+    const lumaxParameters& p = ren.parameters;
+    if (t.maxPositions == p.maxPositions && t.mirrorFactX == p.mirrorFactX && t.mirrorFactY == p.mirrorFactY &&
+        t.scalingX == p.scalingX && t.scalingY == p.scalingY && t.swapXY == p.swapXY &&
+        t.width == screen_width && t.height == screen_height)
+        return t;
+
+    // x in [0, screen_width] -> [mid - sx * M / 2, mid + sx * M / 2]
+    // y in [screen_height, 0] -> [mid - sy * M / 2, mid + sy * M / 2] (see transform)
+    const float mid = p.maxPositions / 2;
+    const float sx = p.scalingX * p.mirrorFactX * p.maxPositions;
+    const float sy = p.scalingY * p.mirrorFactY * p.maxPositions;
+    const float ax = screen_width != 0 ? sx / screen_width : 0;
+    const float bx = screen_width != 0 ? mid - sx / 2 : 0;
+    const float ay = screen_height != 0 ? -sy / screen_height : 0;
+    const float by = screen_height != 0 ? mid + sy / 2 : 0;
+    if (p.swapXY == 1) {
+        // the screen y coordinate is mapped to the Lumax x axis and vice versa
+        const float m[6] = {0, ax, bx, ay, 0, by};
+        std::copy(m, m + 6, t.m);
+    } else {
+        const float m[6] = {ax, 0, bx, 0, ay, by};
+        std::copy(m, m + 6, t.m);
+    }
+
+    t.maxPositions = p.maxPositions;
+    t.mirrorFactX = p.mirrorFactX;
+    t.mirrorFactY = p.mirrorFactY;
+    t.scalingX = p.scalingX;
+    t.scalingY = p.scalingY;
+    t.swapXY = p.swapXY;
+    t.width = screen_width;
+    t.height = screen_height;
+    return t;
+}
+
+void renderer::transformPoints(const affineTransform& t, types::point<float>* points, size_t n) {
+    const float m0 = t.m[0], m1 = t.m[1], m2 = t.m[2];
+    const float m3 = t.m[3], m4 = t.m[4], m5 = t.m[5];
+    ALGORITHMS_PRAGMA(omp simd)
+    for (size_t i = 0; i < n; ++i) {
+        const float x = points[i].x;
+        const float y = points[i].y;
+        points[i].x = m0 * x + m1 * y + m2;
+        points[i].y = m3 * x + m4 * y + m5;
     }
-    float xl = transform(x, 0, screen_width, mid - xScaling * ren.parameters.mirrorFactX * ren.parameters.maxPositions / 2, mid + xScaling * ren.parameters.mirrorFactX * ren.parameters.maxPositions / 2);
-    float yl = transform(y, screen_height, 0, mid - yScaling * ren.parameters.mirrorFactY * ren.parameters.maxPositions / 2, mid + yScaling * ren.parameters.mirrorFactY * ren.parameters.maxPositions / 2);
-    //if (xl >= mid - xScaling * ren.parameters.maxPositions / 2 && xl <= mid + xScaling * ren.parameters.maxPositions / 2 &&
-    //    yl >= mid - yScaling * ren.parameters.maxPositions / 2 && yl <= mid + yScaling * ren.parameters.maxPositions / 2)
-    ren.points.push_back({xl, yl, r, g, b, 1, false});
 }
 
 int renderer::colorPolynom(int value, float a, float b, float c) {
     return algorithms::constrain<int>(a * pow(value, 2.0) + b * value + c, 0, 255);
 }
+
+size_t renderer::resamplePoints(const std::vector<types::point<float>>& points, const lumaxParameters& parameters, std::vector<types::point<float>>* resampled) {
+    auto isDark = [](const types::point<float>& p) { return p.r == 0 && p.g == 0 && p.b == 0; };
+    auto emit = [resampled](const types::point<float>& p, size_t count) {
+        if (resampled)
+            resampled->insert(resampled->end(), count, p);
+        return count;
+    };
+
+    size_t n = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        const types::point<float>& p = points[i];
+        if (i > 0) {
+            // the color of a point is the color of the move to this point:
+            // fill the move with points that are at most maxStep (maxBlankStep if dark) apart
+            const types::point<float>& prev = points[i - 1];
+            const float step = isDark(p) ? (parameters.maxBlankStep > 0 ? parameters.maxBlankStep : parameters.maxStep) : parameters.maxStep;
+            const float dx = p.x - prev.x;
+            const float dy = p.y - prev.y;
+            // wait for the laser at the start of a move that switches between dark and bright
+            if (parameters.blankDwell > 0 && isDark(p) != isDark(prev))
+                n += emit(prev, parameters.blankDwell);
+            if (step > 0) {
+                const int steps = static_cast<int>(std::ceil(std::sqrt(dx * dx + dy * dy) / step));
+                for (int k = 1; k < steps; ++k) {
+                    const float t = static_cast<float>(k) / steps;
+                    n += emit({prev.x + t * dx, prev.y + t * dy, p.r, p.g, p.b, p.a, p.iscollidable}, 1);
+                }
+            }
+        }
+        n += emit(p, 1);
+
+        // dwell at corners to let the galvos follow: no extra points for a straight line, cornerDwell for a reversal
+        if (parameters.cornerDwell > 0 && i > 0 && i + 1 < points.size()) {
+            const types::point<float>& prev = points[i - 1];
+            const types::point<float>& next = points[i + 1];
+            const float ax = p.x - prev.x, ay = p.y - prev.y;
+            const float bx = next.x - p.x, by = next.y - p.y;
+            const float la = std::sqrt(ax * ax + ay * ay);
+            const float lb = std::sqrt(bx * bx + by * by);
+            if (la > 0 && lb > 0) {
+                const float cosAngle = (ax * bx + ay * by) / (la * lb);
+                n += emit(p, static_cast<size_t>(std::lround(parameters.cornerDwell * (1 - cosAngle) / 2)));
+            }
+        }
+    }
+    return n;
+}
 #endif
\ No newline at end of file
@@ -5,6 +5,8 @@
  */
 #pragma once
 #include <SDL.h>
+#include <vector>
+#include <cstddef>
 #include "object.h"
 #include "point.h"
 
@@ -13,6 +15,7 @@
 extern "C" {
 #include "lumax/lumax.h"
 }
+#include "recorder.h"
 #endif
 
 class renderer {
@@ -45,30 +48,123 @@ public:
         float scalingY = 1;
         int swapXY = 0;
         colorCorrectionParameters colorCorr = {0, 1, 0, 0, 1, 0, 0, 1, 0};
+        // resampling of the points before they are sent to the device (in Lumax coordinates, 0 disables it)
+        // maximal distance between two points while the laser is on
+        float maxStep = 0;
+        // maximal distance between two points of a blanked (dark) move
+        float maxBlankStep = 0;
+        // additional points at a corner, scaled by the angle (0 for a straight line, cornerDwell for a reversal)
+        int cornerDwell = 0;
+        // additional points where the laser is switched on or off
+        int blankDwell = 0;
+        // frame rate governor: frame rate that should be held by sendPointsToLumax (0 disables the governor).
+        // If a frame has more points than can be drawn at the scan speed, the resampling density is reduced
+        // down to minDensity and then objects with the lowest priority are dropped.
+        float targetFrameRate = 0;
+        float minDensity = 0.25f;
+    };
+
+    // estimated cost of a frame
+    struct frameEstimate {
+        // number of points after the resampling
+        size_t points;
+        // time to draw the frame in seconds
+        float drawTime;
+        // resulting frame rate in Hz
+        float frameRate;
+    };
+
+    // statistics of the last frame sent by sendPointsToLumax
+    struct frameStatistics {
+        // number of points that were sent
+        size_t points = 0;
+        // predicted frame rate in Hz
+        float frameRate = 0;
+        // resampling density that was used (1: as configured)
+        float density = 1;
+        // number of objects and points that were dropped to hold the target frame rate
+        size_t droppedObjects = 0;
+        size_t droppedPoints = 0;
+    };
+
+    // points of the buffer that belong to one object, [first, last)
+    struct objectRange {
+        size_t first;
+        size_t last;
+        // objects with lower priority are dropped first
+        int priority;
+    };
+
+    // affine mapping from screen to Lumax coordinates:
+    // x' = m[0] * x + m[1] * y + m[2], y' = m[3] * x + m[4] * y + m[5]
+    struct affineTransform {
+        float m[6] = {1, 0, 0, 0, 1, 0};
+        // parameters and screen dimensions the transform was computed for
+        int maxPositions = 0;
+        int mirrorFactX = 0;
+        int mirrorFactY = 0;
+        float scalingX = 0;
+        float scalingY = 0;
+        int swapXY = -1;
+        int width = -1;
+        int height = -1;
     };
 
     // the Lumax renderer
     struct lumaxRenderer {
         std::vector<types::point<float>> points;
+        std::vector<objectRange> objects;
         lumaxParameters parameters;
+        frameStatistics statistics;
+        affineTransform transform;
+        // if set, every frame sent by sendPointsToLumax is also recorded (frames are recorded even without a device)
+        frameRecorder* recorder = nullptr;
     };
 
     // Draw an Object to the Lumax Renderer
-    static void drawObject(const object& object, lumaxRenderer& ren);
+    static void drawObject(const object& object, lumaxRenderer& ren, int priority = 0);
+
+    // Draw a polyline (screen coordinates, colors in [0, 255]) to the Lumax Renderer, framed by dark points
+    static void drawPolyline(const types::point<float>* points, size_t n, lumaxRenderer& ren, int priority = 0);
 
     // send a vector of Points to the Lumax Renderers
-    static void drawPoints(std::vector<types::point<float>>& points, lumaxRenderer& ren);
+    static void drawPoints(std::vector<types::point<float>>& points, lumaxRenderer& ren, int priority = 0);
 
     // send the points in the buffer to the Lumax device
     static int sendPointsToLumax(void *lumaxHandle, lumaxRenderer& ren, int scanSpeed);
 
+    // send a recorded frame to the Lumax device (e.g. as sink of frameReplay::play)
+    static int sendFrameToLumax(void *lumaxHandle, const frameReplay::frame& frame);
+
+    // recompute the screen to Lumax transform of the renderer if the parameters or the screen dimensions changed
+    static const affineTransform& updateTransform(lumaxRenderer& ren);
+
+    // transform n points from screen to Lumax coordinates in place
+    static void transformPoints(const affineTransform& t, types::point<float>* points, size_t n);
+
+    // resample points (in Lumax coordinates) according to maxStep, maxBlankStep, cornerDwell and blankDwell
+    static void resample(const std::vector<types::point<float>>& points, const lumaxParameters& parameters, std::vector<types::point<float>>& resampled);
+
+    // number of points and draw time of the points in the buffer after resampling, scanSpeed in points per second
+    static frameEstimate estimateFrame(const lumaxRenderer& ren, int scanSpeed);
+
 private:
     // function to apply the color polynom to the points
     static void applyColorCorrection(const lumaxRenderer& ren, std::vector<types::point<float>>& points);
 
-    // add a point to the Lumax renderer
-    static void addPoint(lumaxRenderer& ren, float x, float y, int r, int g, int b, float xScaling, float yScaling);
+    // add a point (in screen coordinates) to the Lumax renderer, the points are transformed by transformPoints afterwards
+    static void addPoint(lumaxRenderer& ren, float x, float y, int r, int g, int b);
 
     static int colorPolynom(int value, float a, float b, float c);
+
+    // resample the points of the buffer, scaling down the density and dropping objects if the frame
+    // cannot be drawn with the target frame rate. Updates ren.statistics.
+    static void governFrame(lumaxRenderer& ren, int scanSpeed, std::vector<types::point<float>>& resampled);
+
+    // resampling parameters with the density scaled by factor
+    static lumaxParameters scaledParameters(const lumaxParameters& parameters, float density);
+
+    // resample the points and append them to resampled (if not nullptr), returns the number of resampled points
+    static size_t resamplePoints(const std::vector<types::point<float>>& points, const lumaxParameters& parameters, std::vector<types::point<float>>* resampled);
 #endif
 };
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "scene.h"
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+static_assert(sizeof(scene::sceneObject) % alignof(types::point<float>) == 0, "the points must be aligned in the file");
+
+scene::scene() : m_objects(nullptr), m_points(nullptr), m_numberOfObjects(0), m_numberOfPoints(0) {
+}
+
+bool scene::open(const std::string& filename) {
+    close();
+    if (!m_file.open(filename))
+        return false;
+    const unsigned char* data = m_file.data();
+    const size_t size = m_file.size();
+
+    header h;
+    if (size < sizeof(h)) {
+        close();
+        return false;
+    }
+    std::memcpy(&h, data, sizeof(h));
+    // the counts are checked against the file size before they are multiplied, so that the sizes cannot overflow
+    if (std::memcmp(h.magic, magic, sizeof(magic)) != 0 || h.version != version || h.pointSize != sizeof(types::point<float>) ||
+        h.numberOfObjects > (size - sizeof(h)) / sizeof(sceneObject) ||
+        h.numberOfPoints > (size - sizeof(h) - h.numberOfObjects * sizeof(sceneObject)) / sizeof(types::point<float>) ||
+        sizeof(h) + h.numberOfObjects * sizeof(sceneObject) + h.numberOfPoints * sizeof(types::point<float>) != size) {
+        close();
+        return false;
+    }
+    // the mapping is page aligned, the header and the records keep the arrays aligned
+    m_objects = reinterpret_cast<const sceneObject*>(data + sizeof(h));
+    m_points = reinterpret_cast<const types::point<float>*>(data + sizeof(h) + h.numberOfObjects * sizeof(sceneObject));
+    m_numberOfObjects = h.numberOfObjects;
+    m_numberOfPoints = h.numberOfPoints;
+    for (size_t i = 0; i < m_numberOfObjects; ++i) {
+        if (m_objects[i].firstPoint > m_numberOfPoints || m_objects[i].npoints > m_numberOfPoints - m_objects[i].firstPoint ||
+            m_objects[i].npoints > static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void scene::close() {
+    m_file.close();
+    m_objects = nullptr;
+    m_points = nullptr;
+    m_numberOfObjects = 0;
+    m_numberOfPoints = 0;
+}
+
+size_t scene::numberOfObjects() const {
+    return m_numberOfObjects;
+}
+
+size_t scene::numberOfPoints() const {
+    return m_numberOfPoints;
+}
+
+const scene::sceneObject* scene::objects() const {
+    return m_objects;
+}
+
+const types::point<float>* scene::points() const {
+    return m_points;
+}
+
+void scene::createObjects(std::vector<object>& objects) const {
+    objects.reserve(objects.size() + m_numberOfObjects);
+    for (size_t i = 0; i < m_numberOfObjects; ++i) {
+        const sceneObject& o = m_objects[i];
+        objects.emplace_back(o.x, o.y, o.vx, o.vy, o.hsize, o.vsize, o.angle, o.spin, o.mirrorX, o.mirrorY);
+        objects.back().setMass(o.mass);
+        objects.back().setPoints(m_points + o.firstPoint, static_cast<int>(o.npoints), o.appliedAngle);
+    }
+}
+
+bool scene::load(const std::string& filename, std::vector<object>& objects) {
+    scene s;
+    if (!s.open(filename))
+        return false;
+    s.createObjects(objects);
+    return true;
+}
+
+bool scene::save(const std::string& filename, const std::vector<object>& objects) {
+    std::vector<const object*> pointers;
+    pointers.reserve(objects.size());
+    for (const object& o : objects)
+        pointers.push_back(&o);
+    return save(filename, pointers);
+}
+
+bool scene::save(const std::string& filename, const std::vector<const object*>& objects) {
+    header h;
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version = version;
+    h.pointSize = sizeof(types::point<float>);
+    h.numberOfObjects = static_cast<uint32_t>(objects.size());
+    h.numberOfPoints = 0;
+
+    std::vector<sceneObject> records;
+    records.reserve(objects.size());
+    for (const object* o : objects) {
+        records.push_back({o->x(), o->y(), o->vx(), o->vy(), o->hsize(), o->vsize(), o->phi(), o->appliedAngle(), o->spin(), o->mass(),
+                           o->mirrorX(), o->mirrorY(), static_cast<uint32_t>(o->npoints()), h.numberOfPoints});
+        h.numberOfPoints += static_cast<uint64_t>(o->npoints());
+    }
+
+    FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file)
+        return false;
+    bool ok = std::fwrite(&h, sizeof(h), 1, file) == 1;
+    ok = ok && (records.empty() || std::fwrite(records.data(), sizeof(sceneObject), records.size(), file) == records.size());
+    for (const object* o : objects) {
+        const size_t n = static_cast<size_t>(o->npoints());
+        ok = ok && (n == 0 || std::fwrite(o->localPoints(), sizeof(types::point<float>), n, file) == n);
+    }
+    return std::fclose(file) == 0 && ok;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+/*
+ *  scene.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "object.h"
+#include "point.h"
+#include "mappedfile.h"
+
+// Binary scene format. All objects and all their points are stored in two contiguous arrays, the points already in
+// object coordinates (scaled, mirrored and rotated like object::localPoints), so loading needs neither parsing nor trig.
+// File layout (native byte order and struct layout, i.e. the files are not meant to be exchanged between platforms):
+//   header:  char magic[4] = "LXSC", uint32 version, uint32 sizeof(types::point<float>), uint32 numberOfObjects, uint64 numberOfPoints
+//   objects: sceneObject[numberOfObjects]
+//   points:  types::point<float>[numberOfPoints]
+class scene {
+public:
+    static constexpr char magic[4] = {'L', 'X', 'S', 'C'};
+    static constexpr uint32_t version = 2;
+
+    // an object as stored in the file, its points are [firstPoint, firstPoint + npoints)
+    // (rotated by appliedAngle, the rest of the angle is applied by the next updatePosition like for the saved object)
+    struct sceneObject {
+        float x, y;
+        float vx, vy;
+        float hsize, vsize;
+        float angle, appliedAngle, spin;
+        float mass;
+        int32_t mirrorX, mirrorY;
+        uint32_t npoints;
+        uint64_t firstPoint;
+    };
+
+    scene();
+
+    // open a scene file (memory mapped), returns false if the file cannot be read or is not a valid scene
+    bool open(const std::string& filename);
+    void close();
+
+    // zero copy views of the mapped file, valid until close()
+    size_t numberOfObjects() const;
+    size_t numberOfPoints() const;
+    const sceneObject* objects() const;
+    const types::point<float>* points() const;
+
+    // create the objects of the scene and append them to objects (one bulk copy of the points per object)
+    void createObjects(std::vector<object>& objects) const;
+
+    // load a scene file into objects, returns false on error
+    static bool load(const std::string& filename, std::vector<object>& objects);
+
+    // converter: write objects (e.g. built with object::newPoint from text data) to a scene file, returns false on error
+    static bool save(const std::string& filename, const std::vector<const object*>& objects);
+    static bool save(const std::string& filename, const std::vector<object>& objects);
+
+private:
+    struct header {
+        char magic[4];
+        uint32_t version;
+        uint32_t pointSize;
+        uint32_t numberOfObjects;
+        uint64_t numberOfPoints;
+    };
+
+    mappedFile m_file;
+    const sceneObject* m_objects;
+    const types::point<float>* m_points;
+    size_t m_numberOfObjects;
+    size_t m_numberOfPoints;
+};
\ No newline at end of file
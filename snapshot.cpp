@@ -0,0 +1,112 @@
+#include "snapshot.h"
+#include <cstring>
+#include <algorithm>
+
+snapshot::snapshot() : m_size(0), m_numberOfObjects(0), m_solverOffset(0), m_numberOfSolvers(0), m_base(nullptr) {
+}
+
+void snapshot::reserve(size_t bytes, size_t numberOfObjects) {
+    if (m_buffer.size() < bytes)
+        m_buffer.resize(bytes);
+    m_offsets.reserve(numberOfObjects);
+    m_indices.reserve(numberOfObjects);
+}
+
+unsigned char* snapshot::append(size_t bytes) {
+    if (m_size + bytes > m_buffer.size())
+        m_buffer.resize(std::max(m_size + bytes, 2 * m_buffer.size()));
+    unsigned char* p = m_buffer.data() + m_size;
+    m_size += bytes;
+    return p;
+}
+
+void snapshot::save(const std::vector<object*>& objects, const std::vector<solver*>& solvers) {
+    m_size = 0;
+    m_base = nullptr;
+    m_numberOfObjects = objects.size();
+    m_offsets.resize(objects.size());
+    m_indices.clear();
+    for (size_t i = 0; i < objects.size(); ++i) {
+        m_offsets[i] = m_size;
+        objects[i]->saveState(append(objects[i]->stateSize()));
+    }
+    saveSolvers(solvers);
+}
+
+void snapshot::saveDelta(const snapshot& base, const std::vector<object*>& objects, const std::vector<solver*>& solvers) {
+    // a delta of a delta snapshot refers to the same full snapshot
+    const snapshot& full = base.isDelta() ? *base.m_base : base;
+    if (full.m_numberOfObjects != objects.size()) {
+        save(objects, solvers);
+        return;
+    }
+    m_size = 0;
+    m_base = &full;
+    m_numberOfObjects = objects.size();
+    m_offsets.clear();
+    m_indices.clear();
+    for (size_t i = 0; i < objects.size(); ++i) {
+        // write the state and keep it only if it differs from the base
+        const size_t offset = m_size;
+        const size_t bytes = objects[i]->stateSize();
+        unsigned char* p = append(bytes);
+        objects[i]->saveState(p);
+        const unsigned char* saved = full.m_buffer.data() + full.m_offsets[i];
+        if (object::stateSize(saved) == bytes && std::memcmp(saved, p, bytes) == 0) {
+            m_size = offset;
+        } else {
+            m_indices.push_back(i);
+            m_offsets.push_back(offset);
+        }
+    }
+    saveSolvers(solvers);
+}
+
+void snapshot::restore(const std::vector<object*>& objects, const std::vector<solver*>& solvers) const {
+    if (m_base) {
+        m_base->restore(objects, solvers);
+        for (size_t k = 0; k < m_indices.size(); ++k)
+            objects[m_indices[k]]->restoreState(m_buffer.data() + m_offsets[k]);
+    } else {
+        for (size_t i = 0; i < m_numberOfObjects && i < objects.size(); ++i)
+            objects[i]->restoreState(m_buffer.data() + m_offsets[i]);
+    }
+    restoreSolvers(solvers);
+}
+
+void snapshot::saveSolvers(const std::vector<solver*>& solvers) {
+    m_numberOfSolvers = solvers.size();
+    m_solverOffset = m_size;
+    unsigned char* p = append(solvers.size() * 2 * sizeof(float));
+    for (const solver* s : solvers) {
+        const float state[2] = {s->x(), s->v()};
+        std::memcpy(p, state, sizeof(state));
+        p += sizeof(state);
+    }
+}
+
+void snapshot::restoreSolvers(const std::vector<solver*>& solvers) const {
+    const unsigned char* p = m_buffer.data() + m_solverOffset;
+    for (size_t i = 0; i < m_numberOfSolvers && i < solvers.size(); ++i) {
+        float state[2];
+        std::memcpy(state, p, sizeof(state));
+        solvers[i]->setState(state[0], state[1]);
+        p += sizeof(state);
+    }
+}
+
+bool snapshot::isDelta() const {
+    return m_base != nullptr;
+}
+
+size_t snapshot::size() const {
+    return m_size;
+}
+
+size_t snapshot::numberOfObjects() const {
+    return m_numberOfObjects;
+}
+
+size_t snapshot::storedObjects() const {
+    return m_base ? m_indices.size() : m_numberOfObjects;
+}
\ No newline at end of file
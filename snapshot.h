@@ -0,0 +1,55 @@
+/*
+ *  snapshot.h
+ *  Created by Matthias Kesenheimer on 19.10.26.
+ *  Copyright 2026. All rights reserved.
+ */
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "object.h"
+#include "solver.h"
+
+// Snapshot of the simulation state (all objects and solvers) in one contiguous buffer, e.g. for rollback netcode.
+// The buffer is reused, so saving does not allocate once it is large enough (see reserve), and restoring is a
+// sequence of memcpy's. A delta snapshot only stores the objects that differ from a full base snapshot.
+// Example: keep a full snapshot every n frames and delta snapshots against it in between.
+class snapshot {
+public:
+    snapshot();
+
+    // preallocate bytes for the state and room for the offsets of numberOfObjects objects
+    void reserve(size_t bytes, size_t numberOfObjects = 0);
+
+    // save the state of all objects and solvers
+    void save(const std::vector<object*>& objects, const std::vector<solver*>& solvers = {});
+
+    // save only the objects whose state differs from base (the solvers are always saved). The base must stay
+    // unchanged as long as this snapshot is used. If the number of objects changed, a full snapshot is saved.
+    void saveDelta(const snapshot& base, const std::vector<object*>& objects, const std::vector<solver*>& solvers = {});
+
+    // restore the state, objects and solvers must be the same lists (in the same order) that were saved
+    void restore(const std::vector<object*>& objects, const std::vector<solver*>& solvers = {}) const;
+
+    bool isDelta() const;
+    // used bytes of the buffer
+    size_t size() const;
+    size_t numberOfObjects() const;
+    // number of objects stored in this snapshot (all for a full snapshot, the changed ones for a delta snapshot)
+    size_t storedObjects() const;
+
+private:
+    // room for bytes at the end of the buffer, grows the buffer if needed
+    unsigned char* append(size_t bytes);
+    void saveSolvers(const std::vector<solver*>& solvers);
+    void restoreSolvers(const std::vector<solver*>& solvers) const;
+
+    std::vector<unsigned char> m_buffer;
+    size_t m_size;
+    // full snapshot: offset of every object, delta snapshot: index and offset of the stored objects
+    std::vector<size_t> m_offsets;
+    std::vector<size_t> m_indices;
+    size_t m_numberOfObjects;
+    size_t m_solverOffset;
+    size_t m_numberOfSolvers;
+    const snapshot* m_base;
+};
\ No newline at end of file
@@ -8,6 +8,26 @@ void solver::step(float dt, float* x, float* v) {
   *v = v_;
 }
 
+float solver::x() const {
+  return x_;
+}
+
+float solver::v() const {
+  return v_;
+}
+
+void solver::setState(float x, float v) {
+  x_ = x;
+  v_ = v;
+}
+
+void solver::step(solver* solvers, size_t n, float dt, float* x, float* v, jobSystem& jobs) {
+  jobs.parallelFor(0, n, 256, [=](size_t begin, size_t end, unsigned int) {
+    for (size_t i = begin; i < end; ++i)
+      solvers[i].step(dt, x + i, v + i);
+  });
+}
+
 void rungeKuttaSolver::step(float ww, float bet, float al, float dt, float* x, float* v) {
   float xs = *x, vs = *v;
 
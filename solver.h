@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include "jobs.h"
 
 // solves second order differential equations: x'' = ww * x + bet * x' + al
 class solver {
@@ -7,6 +9,14 @@ class solver {
 
     void step(float dt, float* x, float* v);
 
+    // state of the solver (e.g. for snapshots)
+    float x() const;
+    float v() const;
+    void setState(float x, float v);
+
+    // advance n solvers in parallel, the results of solvers[i] are written to x[i] and v[i]
+    static void step(solver* solvers, size_t n, float dt, float* x, float* v, jobSystem& jobs = jobSystem::instance());
+
   private:
     float x_, v_;
     const float ww_, bet_, al_;
@@ -5,12 +5,127 @@
  */
 #pragma once
 #include <vector>
+#include <iterator>
+#include <utility>
 #include "point.h"
+#include "algorithms.h"
+#include "profiler.h"
 #include <opencv2/opencv.hpp>
 
+// Accessors for the endpoints of different line layouts. An accessor defines the coordinate type,
+// reads the endpoints (x0, y0) -> (x1, y1) of a line and reverses a line in place. Specialize it
+// (or pass an own accessor to sort::sortLines) to chain other line types without copying them.
+template<class Line>
+struct lineAccessor;
+
+// lines stored as cv::Vec<T, 4> = {x0, y0, x1, y1} (e.g. cv::Vec4i from cv::HoughLinesP)
+template<typename T>
+struct lineAccessor<cv::Vec<T, 4>> {
+    using value_type = T;
+    static T x0(const cv::Vec<T, 4>& line) { return line[0]; }
+    static T y0(const cv::Vec<T, 4>& line) { return line[1]; }
+    static T x1(const cv::Vec<T, 4>& line) { return line[2]; }
+    static T y1(const cv::Vec<T, 4>& line) { return line[3]; }
+    static void reverse(cv::Vec<T, 4>& line) {
+        std::swap(line[0], line[2]);
+        std::swap(line[1], line[3]);
+    }
+};
+
+// lines stored as two points
+template<typename T>
+struct lineAccessor<types::line<T>> {
+    using value_type = T;
+    static T x0(const types::line<T>& line) { return line[0].first; }
+    static T y0(const types::line<T>& line) { return line[0].second; }
+    static T x1(const types::line<T>& line) { return line[1].first; }
+    static T y1(const types::line<T>& line) { return line[1].second; }
+    static void reverse(types::line<T>& line) {
+        std::swap(line[0], line[1]);
+    }
+};
+
 class sort {
 public:
+    // Chain the lines: starting with the first line, the line whose start or end point is closest to the
+    // end point of the previous line is moved behind it (and reversed if its end point is the closer one).
+    // The lines are sorted in place, any line layout works via an accessor (see lineAccessor).
+    template<class RandomIt, class Accessor = lineAccessor<typename std::iterator_traits<RandomIt>::value_type>>
+    static void sortLines(RandomIt first, RandomIt last, Accessor accessor = Accessor()) {
+        PROFILE_SCOPE("sort::sortLines");
+        using T = typename Accessor::value_type;
+        const size_t n = static_cast<size_t>(std::distance(first, last));
+        PROFILE_COUNT("lines sorted", n);
+        if (n <= 1)
+            return;
+
+        lineEndpoints<T> endpoints(n);
+        for (size_t i = 0; i < n; ++i) {
+            const auto& line = first[i];
+            endpoints.set(i, accessor.x0(line), accessor.y0(line), accessor.x1(line), accessor.y1(line));
+        }
+
+        for (size_t k = 0; k < n - 1; ++k) {
+            // find closest line and determine closest point of closest line
+            const auto [i, reversed] = endpoints.closest(k);
+
+            // if the points of the line are not in the correct order, swap them
+            if (reversed) {
+                accessor.reverse(first[i]);
+                endpoints.reverse(i);
+            }
+
+            // move the element we found to the current position k + 1
+            if (i != k + 1) {
+                using std::swap;
+                swap(first[k + 1], first[i]);
+                endpoints.swap(k + 1, i);
+            }
+        }
+    }
+
     static void sortLines(std::vector<cv::Vec4i>& lines);
 
     static void sortLines(std::vector<types::line<int>>& lines);
+
+    static void sortLines(std::vector<types::line<float>>& lines);
+
+private:
+    // the endpoints of the lines stored as separate arrays for the batch distance functions
+    template<typename T>
+    struct lineEndpoints {
+        std::vector<T> x0, y0, x1, y1;
+
+        lineEndpoints(size_t n) : x0(n), y0(n), x1(n), y1(n) {}
+
+        void set(size_t i, T ax, T ay, T bx, T by) {
+            x0[i] = ax;
+            y0[i] = ay;
+            x1[i] = bx;
+            y1[i] = by;
+        }
+
+        void swap(size_t i, size_t j) {
+            std::swap(x0[i], x0[j]);
+            std::swap(y0[i], y0[j]);
+            std::swap(x1[i], x1[j]);
+            std::swap(y1[i], y1[j]);
+        }
+
+        void reverse(size_t i) {
+            std::swap(x0[i], x1[i]);
+            std::swap(y0[i], y1[i]);
+        }
+
+        // the line after k whose start or end point is closest to the end point of line k
+        // and whether this line has to be reversed
+        std::pair<size_t, bool> closest(size_t k) const {
+            const size_t first = k + 1;
+            const size_t n = x0.size() - first;
+            const auto [i, reversed, distance] = algorithms::minimalPLineDistance<T>(x1[k], y1[k],
+                x0.data() + first, y0.data() + first, x1.data() + first, y1.data() + first, n);
+            (void)distance;
+            return {first + i, reversed};
+        }
+    };
 };
\ No newline at end of file